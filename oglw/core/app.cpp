@@ -3,6 +3,7 @@
 #include "gl/renderState.h"
 #include "core/types.h"
 #include "core/log.h"
+#include "core/jobSystem.h"
 #include "gl/gl.h"
 #include "oglw.h"
 
@@ -54,6 +55,9 @@ App::App(AppConfiguration _config) {
 App::~App() {
     INFO("App destroy\n");
 
+    // shared GL resources are released while the context is still current
+    OcclusionQuery::releaseResources();
+
     printGLTrace();
 }
 
@@ -112,6 +116,9 @@ void App::initGLFW() {
     }
 
     RenderState::initialize();
+
+    // the scheduler takes the thread creating it as the main thread, running the GL jobs
+    JobSystem::get();
 }
 
 glm::vec2 App::resolution() {
@@ -139,6 +146,9 @@ void App::run() {
             glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
         }
 
+        // GL work queued by the jobs since the last frame, before the app uses its results
+        JobSystem::get().runMainThreadJobs();
+
         update(dt);
 
         glViewport(0, 0, m_config.width * m_dpiRatio, m_config.height * m_dpiRatio);
@@ -0,0 +1,96 @@
+#include "bounds.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+namespace OGLW {
+
+static glm::vec3 readPoint(const unsigned char* _points, size_t _index, size_t _stride, uint _size) {
+    float p[3] = { 0.0f, 0.0f, 0.0f };
+    std::memcpy(p, _points + _index * _stride, std::min(_size, 3u) * sizeof(float));
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+Bounds computeBounds(const void* _points, size_t _count, size_t _stride, uint _size) {
+    Bounds bounds;
+
+    if (_count == 0) {
+        return bounds;
+    }
+
+    const unsigned char* points = static_cast<const unsigned char*>(_points);
+
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(-std::numeric_limits<float>::max());
+
+    for (size_t i = 0; i < _count; ++i) {
+        glm::vec3 p = readPoint(points, i, _stride, _size);
+        bounds.min = glm::min(bounds.min, p);
+        bounds.max = glm::max(bounds.max, p);
+    }
+
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+    float radius2 = 0.0f;
+
+    for (size_t i = 0; i < _count; ++i) {
+        glm::vec3 d = readPoint(points, i, _stride, _size) - bounds.center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+
+    bounds.radius = std::sqrt(radius2);
+
+    return bounds;
+}
+
+Bounds Bounds::transform(const glm::mat4& _transform) const {
+    Bounds bounds;
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    glm::vec3 transformedCenter = glm::vec3(_transform * glm::vec4(center, 1.0f));
+    glm::vec3 transformedExtent(0.0f);
+
+    // the extent of the transformed box along an axis sums the absolute contributions of each axis
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            transformedExtent[i] += std::abs(_transform[j][i]) * extent[j];
+        }
+    }
+
+    float scale = std::max(glm::length(glm::vec3(_transform[0])),
+        std::max(glm::length(glm::vec3(_transform[1])), glm::length(glm::vec3(_transform[2]))));
+
+    bounds.min = transformedCenter - transformedExtent;
+    bounds.max = transformedCenter + transformedExtent;
+    bounds.center = glm::vec3(_transform * glm::vec4(this->center, 1.0f));
+    bounds.radius = radius * scale;
+
+    return bounds;
+}
+
+Bounds Bounds::merge(const Bounds& _other) const {
+    Bounds bounds;
+
+    bounds.min = glm::min(min, _other.min);
+    bounds.max = glm::max(max, _other.max);
+
+    // smallest sphere enclosing both spheres
+    glm::vec3 offset = _other.center - center;
+    float distance = glm::length(offset);
+
+    if (distance + _other.radius <= radius) {
+        bounds.center = center;
+        bounds.radius = radius;
+    } else if (distance + radius <= _other.radius) {
+        bounds.center = _other.center;
+        bounds.radius = _other.radius;
+    } else {
+        bounds.radius = (distance + radius + _other.radius) * 0.5f;
+        bounds.center = center + offset * ((bounds.radius - radius) / distance);
+    }
+
+    return bounds;
+}
+
+} // OGLW
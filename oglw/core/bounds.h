@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include "glm/glm.hpp"
+#include "core/types.h"
+
+namespace OGLW {
+
+// An axis aligned bounding box and a bounding sphere of a set of points. The sphere is centered
+// on the box and its radius is the distance to the furthest point, tighter than the half diagonal.
+struct Bounds {
+    glm::vec3 min;
+    glm::vec3 max;
+    glm::vec3 center;
+    float radius;
+
+    Bounds() : min(0.0f), max(0.0f), center(0.0f), radius(0.0f) {}
+
+    // bounds of the volume transformed by _transform, the box bounds the transformed box and
+    // the sphere radius is scaled by the largest axis scale
+    Bounds transform(const glm::mat4& _transform) const;
+    // bounds of the union of two volumes
+    Bounds merge(const Bounds& _other) const;
+};
+
+// compute the bounds of _count points of _size floats (at most 3 are read) stored _stride bytes apart
+Bounds computeBounds(const void* _points, size_t _count, size_t _stride, uint _size = 3);
+
+} // OGLW
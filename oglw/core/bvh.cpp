@@ -0,0 +1,654 @@
+#include "bvh.h"
+#include "core/log.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace OGLW {
+
+namespace {
+
+enum class Containment { outside, intersecting, inside };
+
+float area(const glm::vec3& _min, const glm::vec3& _max) {
+    glm::vec3 d = _max - _min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+bool overlaps(const glm::vec3& _minA, const glm::vec3& _maxA, const glm::vec3& _minB, const glm::vec3& _maxB) {
+    return _minA.x <= _maxB.x && _minA.y <= _maxB.y && _minA.z <= _maxB.z
+        && _minB.x <= _maxA.x && _minB.y <= _maxA.y && _minB.z <= _maxA.z;
+}
+
+// the frustum planes stored as one register per component, two groups of four planes, the
+// two padding planes always contain the boxes
+struct FrustumPlanes {
+#if defined(__SSE__)
+    __m128 nx[2], ny[2], nz[2], d[2];
+    // lanes whose plane normal component is positive
+    __m128 px[2], py[2], pz[2];
+#else
+    glm::vec4 planes[Frustum::count];
+#endif
+
+    FrustumPlanes(const Frustum& _frustum) {
+#if defined(__SSE__)
+        alignas(16) float values[4][8];
+
+        for (int p = 0; p < 8; ++p) {
+            glm::vec4 plane = p < Frustum::count ? _frustum.getPlane(p) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            for (int c = 0; c < 4; ++c) {
+                values[c][p] = plane[c];
+            }
+        }
+
+        for (int g = 0; g < 2; ++g) {
+            nx[g] = _mm_load_ps(values[0] + g * 4);
+            ny[g] = _mm_load_ps(values[1] + g * 4);
+            nz[g] = _mm_load_ps(values[2] + g * 4);
+            d[g] = _mm_load_ps(values[3] + g * 4);
+            px[g] = _mm_cmpge_ps(nx[g], _mm_setzero_ps());
+            py[g] = _mm_cmpge_ps(ny[g], _mm_setzero_ps());
+            pz[g] = _mm_cmpge_ps(nz[g], _mm_setzero_ps());
+        }
+#else
+        for (int p = 0; p < Frustum::count; ++p) {
+            planes[p] = _frustum.getPlane(p);
+        }
+#endif
+    }
+
+    Containment classify(const glm::vec3& _min, const glm::vec3& _max) const {
+#if defined(__SSE__)
+        bool intersecting = false;
+
+        for (int g = 0; g < 2; ++g) {
+            __m128 minX = _mm_set1_ps(_min.x), minY = _mm_set1_ps(_min.y), minZ = _mm_set1_ps(_min.z);
+            __m128 maxX = _mm_set1_ps(_max.x), maxY = _mm_set1_ps(_max.y), maxZ = _mm_set1_ps(_max.z);
+
+            // the corners the furthest along and against each plane normal
+            __m128 farX = _mm_or_ps(_mm_and_ps(px[g], maxX), _mm_andnot_ps(px[g], minX));
+            __m128 farY = _mm_or_ps(_mm_and_ps(py[g], maxY), _mm_andnot_ps(py[g], minY));
+            __m128 farZ = _mm_or_ps(_mm_and_ps(pz[g], maxZ), _mm_andnot_ps(pz[g], minZ));
+            __m128 nearX = _mm_or_ps(_mm_and_ps(px[g], minX), _mm_andnot_ps(px[g], maxX));
+            __m128 nearY = _mm_or_ps(_mm_and_ps(py[g], minY), _mm_andnot_ps(py[g], maxY));
+            __m128 nearZ = _mm_or_ps(_mm_and_ps(pz[g], minZ), _mm_andnot_ps(pz[g], maxZ));
+
+            __m128 farDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[g], farX), _mm_mul_ps(ny[g], farY)),
+                _mm_add_ps(_mm_mul_ps(nz[g], farZ), d[g]));
+
+            if (_mm_movemask_ps(_mm_cmplt_ps(farDistance, _mm_setzero_ps()))) {
+                return Containment::outside;
+            }
+
+            __m128 nearDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[g], nearX), _mm_mul_ps(ny[g], nearY)),
+                _mm_add_ps(_mm_mul_ps(nz[g], nearZ), d[g]));
+
+            intersecting |= _mm_movemask_ps(_mm_cmplt_ps(nearDistance, _mm_setzero_ps())) != 0;
+        }
+
+        return intersecting ? Containment::intersecting : Containment::inside;
+#else
+        bool intersecting = false;
+
+        for (const auto& plane : planes) {
+            glm::vec3 far(plane.x >= 0.0f ? _max.x : _min.x, plane.y >= 0.0f ? _max.y : _min.y,
+                plane.z >= 0.0f ? _max.z : _min.z);
+            glm::vec3 near(plane.x >= 0.0f ? _min.x : _max.x, plane.y >= 0.0f ? _min.y : _max.y,
+                plane.z >= 0.0f ? _min.z : _max.z);
+
+            if (plane.x * far.x + plane.y * far.y + plane.z * far.z + plane.w < 0.0f) {
+                return Containment::outside;
+            }
+
+            intersecting |= plane.x * near.x + plane.y * near.y + plane.z * near.z + plane.w < 0.0f;
+        }
+
+        return intersecting ? Containment::intersecting : Containment::inside;
+#endif
+    }
+};
+
+// a ray prepared for slab tests
+struct Ray {
+#if defined(__SSE__)
+    __m128 origin;
+    __m128 inverseDirection;
+#else
+    glm::vec3 origin;
+    glm::vec3 inverseDirection;
+#endif
+    float maxDistance;
+
+    Ray(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance) : maxDistance(_maxDistance) {
+        glm::vec3 inverse(1.0f / _direction.x, 1.0f / _direction.y, 1.0f / _direction.z);
+#if defined(__SSE__)
+        origin = _mm_setr_ps(_origin.x, _origin.y, _origin.z, 0.0f);
+        inverseDirection = _mm_setr_ps(inverse.x, inverse.y, inverse.z, 1.0f);
+#else
+        origin = _origin;
+        inverseDirection = inverse;
+#endif
+    }
+
+    // distance to the entry point in the box, negative when the ray misses it
+    float intersect(const glm::vec3& _min, const glm::vec3& _max) const {
+        float near, far;
+#if defined(__SSE__)
+        const float infinity = std::numeric_limits<float>::infinity();
+        // the fourth lane doesn't constrain the interval
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(_min.x, _min.y, _min.z, -infinity), origin), inverseDirection);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(_max.x, _max.y, _max.z, infinity), origin), inverseDirection);
+        __m128 tNear = _mm_min_ps(t1, t2);
+        __m128 tFar = _mm_max_ps(t1, t2);
+
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        near = _mm_cvtss_f32(tNear);
+        far = _mm_cvtss_f32(tFar);
+#else
+        near = -std::numeric_limits<float>::infinity();
+        far = std::numeric_limits<float>::infinity();
+
+        for (int i = 0; i < 3; ++i) {
+            float t1 = (_min[i] - origin[i]) * inverseDirection[i];
+            float t2 = (_max[i] - origin[i]) * inverseDirection[i];
+            near = std::max(near, std::min(t1, t2));
+            far = std::min(far, std::max(t1, t2));
+        }
+#endif
+        near = std::max(near, 0.0f);
+
+        return near <= far && near <= maxDistance ? near : -1.0f;
+    }
+};
+
+} // anonymous
+
+Bvh::Bvh(float _margin) : m_root(nullNode), m_freeList(nullNode), m_leafCount(0), m_margin(_margin) {}
+
+int Bvh::allocateNode() {
+    if (m_freeList == nullNode) {
+        m_nodes.emplace_back();
+        m_nodes.back().parent = nullNode;
+        m_freeList = m_nodes.size() - 1;
+    }
+
+    // free nodes are chained through their parent
+    int node = m_freeList;
+    m_freeList = m_nodes[node].parent;
+
+    m_nodes[node].parent = nullNode;
+    m_nodes[node].child1 = nullNode;
+    m_nodes[node].child2 = nullNode;
+    m_nodes[node].height = 0;
+    m_nodes[node].userData = 0;
+
+    return node;
+}
+
+void Bvh::freeNode(int _node) {
+    m_nodes[_node].parent = m_freeList;
+    m_nodes[_node].height = -1;
+    m_freeList = _node;
+}
+
+Bvh::Proxy Bvh::insert(const glm::vec3& _min, const glm::vec3& _max, uint _userData) {
+    int leaf = allocateNode();
+    glm::vec3 margin(m_margin);
+
+    m_nodes[leaf].min = _min - margin;
+    m_nodes[leaf].max = _max + margin;
+    m_nodes[leaf].userData = _userData;
+
+    insertLeaf(leaf);
+    m_leafCount++;
+
+    return leaf;
+}
+
+void Bvh::remove(Proxy _proxy) {
+    if (_proxy < 0 || _proxy >= (int)m_nodes.size() || !m_nodes[_proxy].isLeaf() || m_nodes[_proxy].height < 0) {
+        WARN("Removing an invalid proxy from the bounding volume hierarchy\n");
+        return;
+    }
+
+    removeLeaf(_proxy);
+    freeNode(_proxy);
+    m_leafCount--;
+}
+
+bool Bvh::update(Proxy _proxy, const glm::vec3& _min, const glm::vec3& _max) {
+    Node& node = m_nodes[_proxy];
+
+    if (node.min.x <= _min.x && node.min.y <= _min.y && node.min.z <= _min.z
+        && _max.x <= node.max.x && _max.y <= node.max.y && _max.z <= node.max.z) {
+        return false;
+    }
+
+    removeLeaf(_proxy);
+
+    glm::vec3 margin(m_margin);
+    m_nodes[_proxy].min = _min - margin;
+    m_nodes[_proxy].max = _max + margin;
+
+    insertLeaf(_proxy);
+
+    return true;
+}
+
+void Bvh::insertLeaf(int _leaf) {
+    if (m_root == nullNode) {
+        m_root = _leaf;
+        m_nodes[_leaf].parent = nullNode;
+        return;
+    }
+
+    glm::vec3 leafMin = m_nodes[_leaf].min;
+    glm::vec3 leafMax = m_nodes[_leaf].max;
+    int index = m_root;
+
+    // descend towards the sibling whose union with the leaf adds the least area to the tree
+    while (!m_nodes[index].isLeaf()) {
+        const Node& node = m_nodes[index];
+        float nodeArea = area(node.min, node.max);
+        float combinedArea = area(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+
+        // cost of making the leaf a sibling of this node, and cost pushed down to the children
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - nodeArea);
+
+        auto descendCost = [&](int _child) {
+            const Node& child = m_nodes[_child];
+            float childArea = area(glm::min(child.min, leafMin), glm::max(child.max, leafMax));
+            return (child.isLeaf() ? childArea : childArea - area(child.min, child.max)) + inheritanceCost;
+        };
+
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    int sibling = index;
+    int oldParent = m_nodes[sibling].parent;
+    int newParent = allocateNode();
+
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].min = glm::min(m_nodes[sibling].min, leafMin);
+    m_nodes[newParent].max = glm::max(m_nodes[sibling].max, leafMax);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = _leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[_leaf].parent = newParent;
+
+    if (oldParent == nullNode) {
+        m_root = newParent;
+    } else if (m_nodes[oldParent].child1 == sibling) {
+        m_nodes[oldParent].child1 = newParent;
+    } else {
+        m_nodes[oldParent].child2 = newParent;
+    }
+
+    refit(m_nodes[_leaf].parent);
+}
+
+void Bvh::removeLeaf(int _leaf) {
+    if (_leaf == m_root) {
+        m_root = nullNode;
+        return;
+    }
+
+    int parent = m_nodes[_leaf].parent;
+    int grandParent = m_nodes[parent].parent;
+    int sibling = m_nodes[parent].child1 == _leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    m_nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    if (grandParent == nullNode) {
+        m_root = sibling;
+        return;
+    }
+
+    if (m_nodes[grandParent].child1 == parent) {
+        m_nodes[grandParent].child1 = sibling;
+    } else {
+        m_nodes[grandParent].child2 = sibling;
+    }
+
+    refit(grandParent);
+}
+
+void Bvh::refit(int _node) {
+    while (_node != nullNode) {
+        _node = balance(_node);
+
+        Node& node = m_nodes[_node];
+        const Node& child1 = m_nodes[node.child1];
+        const Node& child2 = m_nodes[node.child2];
+
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.min = glm::min(child1.min, child2.min);
+        node.max = glm::max(child1.max, child2.max);
+
+        _node = node.parent;
+    }
+}
+
+int Bvh::balance(int _a) {
+    Node& a = m_nodes[_a];
+
+    if (a.isLeaf() || a.height < 2) {
+        return _a;
+    }
+
+    int children[2] = { a.child1, a.child2 };
+    int heightDifference = m_nodes[children[1]].height - m_nodes[children[0]].height;
+
+    if (heightDifference >= -1 && heightDifference <= 1) {
+        return _a;
+    }
+
+    // the taller child becomes the root of the subtree, its shorter child takes its place under a
+    int side = heightDifference > 1 ? 1 : 0;
+    int upIndex = children[side];
+    int otherIndex = children[1 - side];
+    Node& up = m_nodes[upIndex];
+
+    int grandChildren[2] = { up.child1, up.child2 };
+    int tallest = m_nodes[grandChildren[0]].height > m_nodes[grandChildren[1]].height ? 0 : 1;
+    int keptIndex = grandChildren[tallest];
+    int movedIndex = grandChildren[1 - tallest];
+
+    up.child1 = _a;
+    up.child2 = keptIndex;
+    up.parent = a.parent;
+    a.parent = upIndex;
+
+    if (up.parent == nullNode) {
+        m_root = upIndex;
+    } else if (m_nodes[up.parent].child1 == _a) {
+        m_nodes[up.parent].child1 = upIndex;
+    } else {
+        m_nodes[up.parent].child2 = upIndex;
+    }
+
+    if (side == 1) {
+        a.child2 = movedIndex;
+    } else {
+        a.child1 = movedIndex;
+    }
+    m_nodes[movedIndex].parent = _a;
+
+    const Node& other = m_nodes[otherIndex];
+    const Node& moved = m_nodes[movedIndex];
+    const Node& kept = m_nodes[keptIndex];
+
+    a.min = glm::min(other.min, moved.min);
+    a.max = glm::max(other.max, moved.max);
+    a.height = 1 + std::max(other.height, moved.height);
+
+    up.min = glm::min(a.min, kept.min);
+    up.max = glm::max(a.max, kept.max);
+    up.height = 1 + std::max(a.height, kept.height);
+
+    return upIndex;
+}
+
+void Bvh::rebuild() {
+    if (m_root == nullNode) {
+        return;
+    }
+
+    std::vector<int> leaves;
+    leaves.reserve(m_leafCount);
+
+    for (int node = 0; node < (int)m_nodes.size(); ++node) {
+        if (m_nodes[node].height < 0) {
+            continue;
+        }
+
+        if (m_nodes[node].isLeaf()) {
+            leaves.push_back(node);
+        } else {
+            freeNode(node);
+        }
+    }
+
+    m_root = build(leaves, 0, leaves.size());
+    m_nodes[m_root].parent = nullNode;
+}
+
+int Bvh::build(std::vector<int>& _leaves, size_t _begin, size_t _end) {
+    if (_end - _begin == 1) {
+        return _leaves[_begin];
+    }
+
+    const int nBins = 16;
+
+    glm::vec3 centroidMin(std::numeric_limits<float>::max());
+    glm::vec3 centroidMax(-std::numeric_limits<float>::max());
+
+    for (size_t i = _begin; i < _end; ++i) {
+        const Node& leaf = m_nodes[_leaves[i]];
+        glm::vec3 centroid = (leaf.min + leaf.max) * 0.5f;
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+
+    glm::vec3 extent = centroidMax - centroidMin;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    size_t middle = _begin + (_end - _begin) / 2;
+
+    if (extent[axis] > 0.0f) {
+        auto binOf = [&](int _leaf) {
+            const Node& leaf = m_nodes[_leaf];
+            float centroid = (leaf.min[axis] + leaf.max[axis]) * 0.5f;
+            int bin = int((centroid - centroidMin[axis]) / extent[axis] * nBins);
+            return std::min(bin, nBins - 1);
+        };
+
+        struct Bin {
+            glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+            glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+            size_t count = 0;
+        };
+
+        Bin bins[nBins];
+
+        for (size_t i = _begin; i < _end; ++i) {
+            const Node& leaf = m_nodes[_leaves[i]];
+            Bin& bin = bins[binOf(_leaves[i])];
+            bin.min = glm::min(bin.min, leaf.min);
+            bin.max = glm::max(bin.max, leaf.max);
+            bin.count++;
+        }
+
+        // sweep the bins from the right to get the cost of the right side of each split
+        float rightCost[nBins];
+        Bin right;
+
+        for (int b = nBins - 1; b > 0; --b) {
+            right.min = glm::min(right.min, bins[b].min);
+            right.max = glm::max(right.max, bins[b].max);
+            right.count += bins[b].count;
+            rightCost[b] = right.count > 0 ? right.count * area(right.min, right.max) : 0.0f;
+        }
+
+        Bin left;
+        float bestCost = std::numeric_limits<float>::max();
+        int bestSplit = -1;
+
+        for (int b = 1; b < nBins; ++b) {
+            left.min = glm::min(left.min, bins[b - 1].min);
+            left.max = glm::max(left.max, bins[b - 1].max);
+            left.count += bins[b - 1].count;
+
+            float cost = (left.count > 0 ? left.count * area(left.min, left.max) : 0.0f) + rightCost[b];
+
+            if (left.count > 0 && left.count < _end - _begin && cost < bestCost) {
+                bestCost = cost;
+                bestSplit = b;
+            }
+        }
+
+        if (bestSplit > 0) {
+            auto split = std::partition(_leaves.begin() + _begin, _leaves.begin() + _end,
+                [&](int _leaf) { return binOf(_leaf) < bestSplit; });
+            middle = split - _leaves.begin();
+        }
+    }
+
+    // coincident centroids can't be split by position, split them by count
+    if (middle == _begin || middle == _end) {
+        middle = _begin + (_end - _begin) / 2;
+    }
+
+    int node = allocateNode();
+    int child1 = build(_leaves, _begin, middle);
+    int child2 = build(_leaves, middle, _end);
+
+    m_nodes[node].child1 = child1;
+    m_nodes[node].child2 = child2;
+    m_nodes[node].min = glm::min(m_nodes[child1].min, m_nodes[child2].min);
+    m_nodes[node].max = glm::max(m_nodes[child1].max, m_nodes[child2].max);
+    m_nodes[node].height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+    m_nodes[child1].parent = node;
+    m_nodes[child2].parent = node;
+
+    return node;
+}
+
+float Bvh::getCost() const {
+    if (m_root == nullNode) {
+        return 0.0f;
+    }
+
+    float rootArea = area(m_nodes[m_root].min, m_nodes[m_root].max);
+    float cost = 0.0f;
+
+    for (const auto& node : m_nodes) {
+        if (node.height > 0) {
+            cost += area(node.min, node.max);
+        }
+    }
+
+    return rootArea > 0.0f ? cost / rootArea : 0.0f;
+}
+
+void Bvh::collectLeaves(int _node, std::vector<uint>& _results) const {
+    std::vector<int> stack(1, _node);
+
+    while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        if (node.isLeaf()) {
+            _results.push_back(node.userData);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void Bvh::queryFrustum(const Frustum& _frustum, std::vector<uint>& _results) const {
+    if (m_root == nullNode) {
+        return;
+    }
+
+    FrustumPlanes planes(_frustum);
+    std::vector<int> stack(1, m_root);
+
+    while (!stack.empty()) {
+        int index = stack.back();
+        const Node& node = m_nodes[index];
+        stack.pop_back();
+
+        Containment containment = planes.classify(node.min, node.max);
+
+        if (containment == Containment::outside) {
+            continue;
+        }
+
+        // the leaves of a node fully inside the frustum don't need to be tested
+        if (node.isLeaf() || containment == Containment::inside) {
+            collectLeaves(index, _results);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void Bvh::queryBox(const glm::vec3& _min, const glm::vec3& _max, std::vector<uint>& _results) const {
+    if (m_root == nullNode) {
+        return;
+    }
+
+    std::vector<int> stack(1, m_root);
+
+    while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        if (!overlaps(node.min, node.max, _min, _max)) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            _results.push_back(node.userData);
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void Bvh::queryRay(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance,
+    std::vector<RayHit>& _hits) const
+{
+    if (m_root == nullNode) {
+        return;
+    }
+
+    Ray ray(_origin, _direction, _maxDistance);
+    std::vector<int> stack(1, m_root);
+    size_t firstHit = _hits.size();
+
+    while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+
+        float distance = ray.intersect(node.min, node.max);
+
+        if (distance < 0.0f) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            _hits.push_back({ node.userData, distance });
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    std::sort(_hits.begin() + firstHit, _hits.end(), [](const RayHit& _a, const RayHit& _b) {
+        return _a.distance < _b.distance;
+    });
+}
+
+} // OGLW
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "core/types.h"
+#include "core/frustum.h"
+
+namespace OGLW {
+
+// A dynamic bounding volume hierarchy of axis aligned boxes, indexing scene objects for frustum,
+// ray and box queries. Leaves store fattened boxes so that objects moving a little don't modify
+// the tree, and leaves are inserted next to the sibling minimizing the surface area of the tree,
+// rebalanced with rotations on the way up. rebuild() builds the whole tree again top down with the
+// surface area heuristic when incremental updates have degraded it. Node boxes are tested against
+// the frustum planes and the ray slabs with SSE when available.
+class Bvh {
+public:
+    // a leaf of the tree, valid until removed, stable across updates and rebuilds
+    typedef int Proxy;
+    static const Proxy nullProxy = -1;
+
+    // an object crossed by a ray
+    struct RayHit {
+        uint userData;
+        // distance along the ray to the entry point in the object box
+        float distance;
+    };
+
+    // _margin is the distance the boxes of the leaves are fattened by
+    Bvh(float _margin = 0.1f);
+
+    // insert an object with its bounding box and return its proxy
+    Proxy insert(const glm::vec3& _min, const glm::vec3& _max, uint _userData);
+    // remove an object from the tree
+    void remove(Proxy _proxy);
+    // update the bounding box of a moved object, the leaf is only reinserted when the box leaves
+    // its fattened box, returns whether the tree was modified
+    bool update(Proxy _proxy, const glm::vec3& _min, const glm::vec3& _max);
+    // rebuild the tree top down with the surface area heuristic, the proxies stay valid
+    void rebuild();
+
+    // get the user data of an object
+    uint getUserData(Proxy _proxy) const { return m_nodes[_proxy].userData; }
+    // number of objects in the tree
+    size_t size() const { return m_leafCount; }
+    // height of the tree, 0 for a single leaf
+    int getHeight() const { return m_root == nullNode ? 0 : m_nodes[m_root].height; }
+    // surface area heuristic cost of the tree, the sum of the areas of the internal nodes relative
+    // to the root area, lower is better
+    float getCost() const;
+
+    // append the user data of the objects whose box intersects the frustum to _results
+    void queryFrustum(const Frustum& _frustum, std::vector<uint>& _results) const;
+    // append the user data of the objects whose box overlaps the box [_min, _max] to _results
+    void queryBox(const glm::vec3& _min, const glm::vec3& _max, std::vector<uint>& _results) const;
+    // append the objects whose box is crossed by the ray within _maxDistance to _hits, sorted by distance,
+    // _direction doesn't need to be normalized, distances are in units of its length
+    void queryRay(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance,
+        std::vector<RayHit>& _hits) const;
+
+private:
+    static const int nullNode = -1;
+
+    struct Node {
+        glm::vec3 min;
+        glm::vec3 max;
+        int parent;
+        int child1;
+        int child2;
+        // leaf at 0, -1 for a free node
+        int height;
+        uint userData;
+
+        bool isLeaf() const { return child1 == nullNode; }
+    };
+
+    int allocateNode();
+    void freeNode(int _node);
+    void insertLeaf(int _leaf);
+    void removeLeaf(int _leaf);
+    // rotate the subtree of _node if it is imbalanced and return its new root
+    int balance(int _node);
+    // refit the boxes and heights from _node up to the root, balancing the subtrees on the way
+    void refit(int _node);
+    // build the subtree of the leaves in [_begin, _end) with the binned surface area heuristic
+    int build(std::vector<int>& _leaves, size_t _begin, size_t _end);
+    // append the user data of all the leaves under _node
+    void collectLeaves(int _node, std::vector<uint>& _results) const;
+
+    std::vector<Node> m_nodes;
+    int m_root;
+    int m_freeList;
+    size_t m_leafCount;
+    float m_margin;
+};
+
+} // OGLW
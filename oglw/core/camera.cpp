@@ -1,13 +1,15 @@
 #include "camera.h"
 
 #include "glm/gtc/matrix_transform.hpp"
+#include "gl/renderState.h"
 #include "core/utils.h"
+#include "core/log.h"
 
 namespace OGLW {
 
 Camera::Camera()
     : m_position(0.0f, 0.0f, 0.0f), m_rotation(0.0f, 0.0f), m_aspectRatio(4 / 3), m_fov(50.0f), m_near(0.01f),
-      m_far(1000.0f) {
+      m_far(1000.0f), m_reverseZ(false) {
 }
 
 Camera::~Camera() {
@@ -15,32 +17,33 @@ Camera::~Camera() {
 
 void Camera::setAspectRatio(float _ratio) {
     m_aspectRatio = _ratio;
+    projectionChanged();
 }
 
-glm::mat4 Camera::getRotationMatrix() const {
-    glm::mat4 rotationMatrix;
-    rotationMatrix = glm::rotate(rotationMatrix, m_rotation.x, glm::vec3(1, 0, 0));
-    rotationMatrix = glm::rotate(rotationMatrix, m_rotation.y, glm::vec3(0, 1, 0));
-    return rotationMatrix;
+const glm::mat4& Camera::getRotationMatrix() const {
+    if (m_viewDirty) {
+        updateView();
+    }
+
+    return m_rotationMatrix;
 }
 
 void Camera::translate(glm::vec3 _vec) {
     m_position += _vec;
+    viewChanged();
 }
 
+// the rows of the rotation are the camera axes in world space, the columns of its inverse
 glm::vec3 Camera::forward() const {
-    glm::vec4 forward = glm::inverse(getRotationMatrix()) * glm::vec4(0, 0, -1, 1);
-    return glm::vec3(forward);
+    return -glm::vec3(getInverseViewMatrix()[2]);
 }
 
 glm::vec3 Camera::up() const {
-    glm::vec4 up = glm::inverse(getRotationMatrix()) * glm::vec4(0, 1, 0, 1);
-    return glm::vec3(up);
+    return glm::vec3(getInverseViewMatrix()[1]);
 }
 
 glm::vec3 Camera::right() const {
-    glm::vec4 right = glm::inverse(getRotationMatrix()) * glm::vec4(1, 0, 0, 1);
-    return glm::vec3(right);
+    return glm::vec3(getInverseViewMatrix()[0]);
 }
 
 glm::vec2 Camera::rotation() const {
@@ -53,27 +56,133 @@ glm::vec3 Camera::getPosition() const {
 
 void Camera::setPosition(glm::vec3 _position) {
     m_position = _position;
+    viewChanged();
 }
 
 void Camera::rotate(glm::vec2 _rotation) {
     m_rotation += _rotation;
+    viewChanged();
     normalizeAngles();
 }
 
-glm::mat4 Camera::getProjectionMatrix() const {
-    return glm::perspective(m_fov, m_aspectRatio, m_near, m_far);
+void Camera::updateView() const {
+    m_rotationMatrix = glm::mat4();
+    m_rotationMatrix = glm::rotate(m_rotationMatrix, m_rotation.x, glm::vec3(1, 0, 0));
+    m_rotationMatrix = glm::rotate(m_rotationMatrix, m_rotation.y, glm::vec3(0, 1, 0));
+
+    m_view = glm::translate(m_rotationMatrix, -m_position);
+
+    // the inverse of a rotation is its transpose
+    m_inverseView = glm::transpose(m_rotationMatrix);
+    m_inverseView[3] = glm::vec4(m_position, 1.0f);
+
+    m_viewDirty = false;
+}
+
+void Camera::updateProjection() const {
+    m_projection = glm::perspective(m_fov, m_aspectRatio, m_near, m_far);
+
+    if (m_reverseZ) {
+        // keep the field of view scales, map the near plane to 1 and infinity to 0
+        m_projection[2] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+        m_projection[3] = glm::vec4(0.0f, 0.0f, m_near, 0.0f);
+    }
+
+    m_inverseProjection = glm::inverse(m_projection);
+    m_projectionDirty = false;
+}
+
+void Camera::updateViewProjection() const {
+    m_viewProjection = getProjectionMatrix() * getViewMatrix();
+    m_inverseViewProjection = getInverseViewMatrix() * getInverseProjectionMatrix();
+
+    // the planes of a reverse Z projection are extracted in the same way but swap roles, the
+    // extracted near plane (w + z >= 0) is degenerate and keeps everything in front of the camera,
+    // the extracted far plane (w - z >= 0) rejects what is closer than the near distance, and
+    // nothing bounds the distance since the far plane is at infinity
+    m_frustum = Frustum(m_viewProjection);
+    m_viewProjectionDirty = false;
+}
+
+const glm::mat4& Camera::getProjectionMatrix() const {
+    if (m_projectionDirty) {
+        updateProjection();
+    }
+
+    return m_projection;
+}
+
+const glm::mat4& Camera::getInverseProjectionMatrix() const {
+    if (m_projectionDirty) {
+        updateProjection();
+    }
+
+    return m_inverseProjection;
+}
+
+const glm::mat4& Camera::getViewMatrix() const {
+    if (m_viewDirty) {
+        updateView();
+    }
+
+    return m_view;
+}
+
+const glm::mat4& Camera::getInverseViewMatrix() const {
+    if (m_viewDirty) {
+        updateView();
+    }
+
+    return m_inverseView;
+}
+
+const glm::mat4& Camera::getViewProjectionMatrix() const {
+    if (m_viewProjectionDirty) {
+        updateViewProjection();
+    }
+
+    return m_viewProjection;
+}
+
+const glm::mat4& Camera::getInverseViewProjectionMatrix() const {
+    if (m_viewProjectionDirty) {
+        updateViewProjection();
+    }
+
+    return m_inverseViewProjection;
 }
 
-glm::mat4 Camera::getViewMatrix() const {
-    glm::mat4 view = getRotationMatrix();
-    view = glm::translate(view, -m_position);
-    return view;
+const Frustum& Camera::getFrustum() const {
+    if (m_viewProjectionDirty) {
+        updateViewProjection();
+    }
+
+    return m_frustum;
+}
+
+void Camera::applyDepthState() const {
+    RenderState::depthFunc(m_reverseZ ? GL_GEQUAL : GL_LEQUAL);
+    RenderState::clearDepth(m_reverseZ ? 0.0 : 1.0);
+
+    // without clip control the depth is remapped from [-1, 1] and the reverse Z precision is lost,
+    // the projection still works
+    if (GLEW_VERSION_4_5 || GLEW_ARB_clip_control) {
+        GL_CHECK(glClipControl(GL_LOWER_LEFT, m_reverseZ ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE));
+    } else if (m_reverseZ) {
+        static bool warned = false;
+
+        if (!warned) {
+            WARN("Clip control isn't supported, reverse Z won't improve the depth precision\n");
+            warned = true;
+        }
+    }
 }
 
 void Camera::lookAt(glm::vec3 _point) {
     glm::vec3 direction = glm::normalize(m_position - _point);
     m_rotation.x = rad2deg(atan2f(direction.x, direction.z));
     m_rotation.y = rad2deg(acosf(direction.y));
+    viewChanged();
 
     normalizeAngles();
 }
@@ -4,9 +4,12 @@
 #include <iostream>
 #include <cmath>
 #include "glm/glm.hpp"
+#include "core/frustum.h"
 
 namespace OGLW {
 
+// A free fly camera. The view and projection matrices, their product, their inverses and the
+// frustum planes are cached and only computed again after the camera changed.
 class Camera {
 public:
     Camera();
@@ -19,16 +22,21 @@ public:
     glm::vec3 up() const;
     glm::vec3 right() const;
     glm::vec2 rotation() const;
-    glm::mat4 getViewMatrix() const;
-    glm::mat4 getRotationMatrix() const;
-    glm::mat4 getProjectionMatrix() const;
+    const glm::mat4& getViewMatrix() const;
+    const glm::mat4& getRotationMatrix() const;
+    const glm::mat4& getProjectionMatrix() const;
+    // get the product of the projection and view matrices
+    const glm::mat4& getViewProjectionMatrix() const;
+    const glm::mat4& getInverseViewMatrix() const;
+    const glm::mat4& getInverseProjectionMatrix() const;
+    const glm::mat4& getInverseViewProjectionMatrix() const;
     glm::vec3 getPosition() const;
 
     void translate(glm::vec3 _vec);
     void rotate(glm::vec2 _rotation);
-    void setRotationX(float _rotX) { m_rotation.x = _rotX; }
-    void setRotationY(float _rotY) { m_rotation.y = _rotY; }
-    void setRotation(glm::vec2 _rotation) { m_rotation = _rotation; }
+    void setRotationX(float _rotX) { m_rotation.x = _rotX; viewChanged(); }
+    void setRotationY(float _rotY) { m_rotation.y = _rotY; viewChanged(); }
+    void setRotation(glm::vec2 _rotation) { m_rotation = _rotation; viewChanged(); }
     glm::vec2 getRotation() const { return m_rotation; }
 
     void lookAt(glm::vec3 _point);
@@ -36,11 +44,26 @@ public:
     float getNear() const { return m_near; }
     float getFar() const { return m_far; }
     float getFov() const { return m_fov; }
-    void setNear(float _near) { m_near = _near; }
-    void setFar(float _far) { m_far = _far; }
-    void setFov(float _fov) { m_fov = _fov; }
+    void setNear(float _near) { m_near = _near; projectionChanged(); }
+    void setFar(float _far) { m_far = _far; projectionChanged(); }
+    void setFov(float _fov) { m_fov = _fov; projectionChanged(); }
+    // use a reverse Z projection with an infinite far plane, depth is 1 on the near plane and goes
+    // to 0 at infinity, which spreads the float depth precision evenly with the distance, meant to
+    // be used with a float depth target (see RenderTargetSetup::floatDepth) and applyDepthState()
+    void setReverseZ(bool _reverseZ) { m_reverseZ = _reverseZ; projectionChanged(); }
+    bool isReverseZ() const { return m_reverseZ; }
+    // set the depth function, depth clear value and clip control matching the camera projection
+    void applyDepthState() const;
+    // get the world space frustum planes of the camera, extracted again only when the camera changed
+    const Frustum& getFrustum() const;
 
 private:
+    void viewChanged() { m_viewDirty = true; m_viewProjectionDirty = true; }
+    void projectionChanged() { m_projectionDirty = true; m_viewProjectionDirty = true; }
+    void updateView() const;
+    void updateProjection() const;
+    void updateViewProjection() const;
+
     glm::vec3 m_position;
     glm::vec2 m_rotation;
 
@@ -48,8 +71,22 @@ private:
     float m_fov;
     float m_near;
     float m_far;
+    bool m_reverseZ;
 
     const float m_maxRotationX = 89.0f;
+
+    mutable glm::mat4 m_rotationMatrix;
+    mutable glm::mat4 m_view;
+    mutable glm::mat4 m_inverseView;
+    mutable glm::mat4 m_projection;
+    mutable glm::mat4 m_inverseProjection;
+    mutable glm::mat4 m_viewProjection;
+    mutable glm::mat4 m_inverseViewProjection;
+    mutable Frustum m_frustum;
+    mutable bool m_viewDirty = true;
+    mutable bool m_projectionDirty = true;
+    // the view projection matrices and the frustum
+    mutable bool m_viewProjectionDirty = true;
 };
 
 } // OGLW
@@ -0,0 +1,166 @@
+#include "culling.h"
+#include "core/parallel.h"
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace OGLW {
+
+// smallest range of volumes tested by a thread
+static const size_t cullingGrainSize = 4096;
+
+// the arrays the test reads for a plane, the box corner the furthest along the plane normal
+struct PlaneInput {
+    glm::vec4 plane;
+    const float* x;
+    const float* y;
+    const float* z;
+    // sphere radii, null for boxes
+    const float* radius;
+};
+
+// append the indices in [_begin, _end) whose volume is in front of all the planes to _visible
+static void cullRange(const PlaneInput* _planes, size_t _begin, size_t _end, std::vector<uint>& _visible) {
+    size_t i = _begin;
+
+#if defined(__AVX__)
+    for (; i + 8 <= _end; i += 8) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (int p = 0; p < Frustum::count; ++p) {
+            const PlaneInput& in = _planes[p];
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(in.plane.x), _mm256_loadu_ps(in.x + i)),
+                              _mm256_mul_ps(_mm256_set1_ps(in.plane.y), _mm256_loadu_ps(in.y + i))),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(in.plane.z), _mm256_loadu_ps(in.z + i)),
+                              _mm256_set1_ps(in.plane.w)));
+
+            if (in.radius) {
+                distance = _mm256_add_ps(distance, _mm256_loadu_ps(in.radius + i));
+            }
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        while (mask) {
+            int bit = __builtin_ctz(mask);
+            _visible.push_back(i + bit);
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE__)
+    for (; i + 4 <= _end; i += 4) {
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+
+        for (int p = 0; p < Frustum::count; ++p) {
+            const PlaneInput& in = _planes[p];
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(in.plane.x), _mm_loadu_ps(in.x + i)),
+                           _mm_mul_ps(_mm_set1_ps(in.plane.y), _mm_loadu_ps(in.y + i))),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(in.plane.z), _mm_loadu_ps(in.z + i)),
+                           _mm_set1_ps(in.plane.w)));
+
+            if (in.radius) {
+                distance = _mm_add_ps(distance, _mm_loadu_ps(in.radius + i));
+            }
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        while (mask) {
+            int bit = __builtin_ctz(mask);
+            _visible.push_back(i + bit);
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < _end; ++i) {
+        bool inside = true;
+
+        for (int p = 0; p < Frustum::count && inside; ++p) {
+            const PlaneInput& in = _planes[p];
+            float distance = in.plane.x * in.x[i] + in.plane.y * in.y[i] + in.plane.z * in.z[i] + in.plane.w;
+
+            if (in.radius) {
+                distance += in.radius[i];
+            }
+
+            inside = distance >= 0.0f;
+        }
+
+        if (inside) {
+            _visible.push_back(i);
+        }
+    }
+}
+
+// test the volumes in concurrent ranges and concatenate the visible indices in order
+static void cull(const PlaneInput* _planes, size_t _count, std::vector<uint>& _visible, uint _threads) {
+    _visible.clear();
+
+    size_t nRanges = std::max<size_t>(1, std::min<size_t>(_threads > 0 ? _threads : hardwareThreads(),
+        (_count + cullingGrainSize - 1) / cullingGrainSize));
+
+    if (nRanges == 1) {
+        cullRange(_planes, 0, _count, _visible);
+        return;
+    }
+
+    size_t rangeSize = (_count + nRanges - 1) / nRanges;
+    std::vector<std::vector<uint>> rangeVisible(nRanges);
+
+    parallelFor(0, nRanges, 1, [&](size_t _begin, size_t _end) {
+        for (size_t range = _begin; range < _end; ++range) {
+            size_t start = range * rangeSize;
+            rangeVisible[range].reserve(rangeSize);
+            cullRange(_planes, start, std::min(start + rangeSize, _count), rangeVisible[range]);
+        }
+    });
+
+    for (const auto& visible : rangeVisible) {
+        _visible.insert(_visible.end(), visible.begin(), visible.end());
+    }
+}
+
+void cullAABBs(const Frustum& _frustum, const AABBArray& _boxes, std::vector<uint>& _visible, uint _threads) {
+    PlaneInput planes[Frustum::count];
+
+    // a box is outside of a plane when its corner the furthest along the plane normal is
+    for (int p = 0; p < Frustum::count; ++p) {
+        const glm::vec4& plane = _frustum.getPlane(p);
+        planes[p] = {
+            plane,
+            plane.x >= 0.0f ? _boxes.maxX.data() : _boxes.minX.data(),
+            plane.y >= 0.0f ? _boxes.maxY.data() : _boxes.minY.data(),
+            plane.z >= 0.0f ? _boxes.maxZ.data() : _boxes.minZ.data(),
+            nullptr
+        };
+    }
+
+    cull(planes, _boxes.size(), _visible, _threads);
+}
+
+void cullSpheres(const Frustum& _frustum, const SphereArray& _spheres, std::vector<uint>& _visible,
+    uint _threads)
+{
+    PlaneInput planes[Frustum::count];
+
+    for (int p = 0; p < Frustum::count; ++p) {
+        planes[p] = {
+            _frustum.getPlane(p),
+            _spheres.x.data(),
+            _spheres.y.data(),
+            _spheres.z.data(),
+            _spheres.radius.data()
+        };
+    }
+
+    cull(planes, _spheres.size(), _visible, _threads);
+}
+
+} // OGLW
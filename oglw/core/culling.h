@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "glm/glm.hpp"
+#include "core/types.h"
+#include "core/frustum.h"
+
+namespace OGLW {
+
+// Visibility tests of large sets of bounding volumes against a frustum. The volumes are stored
+// as one array per component so that 8 (AVX) or 4 (SSE) of them are tested against a plane at
+// once, large sets are split in ranges tested concurrently. The visible indices are output in
+// increasing order, ready to be used to submit the draws of the visible objects.
+
+// axis aligned bounding boxes stored as one array per component
+struct AABBArray {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void push_back(const glm::vec3& _min, const glm::vec3& _max) {
+        minX.push_back(_min.x); minY.push_back(_min.y); minZ.push_back(_min.z);
+        maxX.push_back(_max.x); maxY.push_back(_max.y); maxZ.push_back(_max.z);
+    }
+    void set(size_t _index, const glm::vec3& _min, const glm::vec3& _max) {
+        minX[_index] = _min.x; minY[_index] = _min.y; minZ[_index] = _min.z;
+        maxX[_index] = _max.x; maxY[_index] = _max.y; maxZ[_index] = _max.z;
+    }
+    void resize(size_t _size) {
+        minX.resize(_size); minY.resize(_size); minZ.resize(_size);
+        maxX.resize(_size); maxY.resize(_size); maxZ.resize(_size);
+    }
+    void clear() { resize(0); }
+    size_t size() const { return minX.size(); }
+};
+
+// bounding spheres stored as one array per component
+struct SphereArray {
+    std::vector<float> x, y, z;
+    std::vector<float> radius;
+
+    void push_back(const glm::vec3& _center, float _radius) {
+        x.push_back(_center.x); y.push_back(_center.y); z.push_back(_center.z);
+        radius.push_back(_radius);
+    }
+    void set(size_t _index, const glm::vec3& _center, float _radius) {
+        x[_index] = _center.x; y[_index] = _center.y; z[_index] = _center.z;
+        radius[_index] = _radius;
+    }
+    void resize(size_t _size) { x.resize(_size); y.resize(_size); z.resize(_size); radius.resize(_size); }
+    void clear() { resize(0); }
+    size_t size() const { return x.size(); }
+};
+
+// fill _visible with the indices of the boxes intersecting the frustum, _threads 0 uses all the
+// hardware threads
+void cullAABBs(const Frustum& _frustum, const AABBArray& _boxes, std::vector<uint>& _visible, uint _threads = 0);
+
+// fill _visible with the indices of the spheres intersecting the frustum, _threads 0 uses all the
+// hardware threads
+void cullSpheres(const Frustum& _frustum, const SphereArray& _spheres, std::vector<uint>& _visible,
+    uint _threads = 0);
+
+} // OGLW
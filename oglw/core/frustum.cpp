@@ -0,0 +1,56 @@
+#include "frustum.h"
+#include <cmath>
+
+namespace OGLW {
+
+Frustum::Frustum(const glm::mat4& _viewProjection) {
+    const glm::mat4& m = _viewProjection;
+
+    // rows of the matrix, the clip space conditions -w <= x, y, z <= w are plane equations on them
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+
+    m_planes[left] = rows[3] + rows[0];
+    m_planes[right] = rows[3] - rows[0];
+    m_planes[bottom] = rows[3] + rows[1];
+    m_planes[top] = rows[3] - rows[1];
+    m_planes[near] = rows[3] + rows[2];
+    m_planes[far] = rows[3] - rows[2];
+
+    for (auto& plane : m_planes) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+
+        if (length > 0.0f) {
+            plane = plane / length;
+        }
+    }
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& _center, float _radius) const {
+    for (const auto& plane : m_planes) {
+        if (plane.x * _center.x + plane.y * _center.y + plane.z * _center.z + plane.w < -_radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Frustum::intersectsAABB(const glm::vec3& _min, const glm::vec3& _max) const {
+    for (const auto& plane : m_planes) {
+        // the corner of the box the furthest along the plane normal
+        float x = plane.x >= 0.0f ? _max.x : _min.x;
+        float y = plane.y >= 0.0f ? _max.y : _min.y;
+        float z = plane.z >= 0.0f ? _max.z : _min.z;
+
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // OGLW
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+namespace OGLW {
+
+// The six clipping planes of a view volume, extracted from a view projection matrix. Each plane
+// is stored as (normal, distance) with the normal pointing inside the volume and normalized, so
+// that dot(normal, p) + distance is the signed distance of p to the plane.
+class Frustum {
+public:
+    enum Plane { left = 0, right, bottom, top, near, far, count };
+
+    Frustum() {}
+    // extract the planes of a view projection matrix with a [-1, 1] clip space depth range,
+    // the planes are in the space the matrix transforms from, e.g. world space for projection * view
+    explicit Frustum(const glm::mat4& _viewProjection);
+
+    // get a plane as (normal, distance)
+    const glm::vec4& getPlane(int _plane) const { return m_planes[_plane]; }
+    // whether a sphere is at least partially inside the frustum
+    bool intersectsSphere(const glm::vec3& _center, float _radius) const;
+    // whether an axis aligned box is at least partially inside the frustum, conservative near the
+    // frustum corners where a box outside of the volume may still be reported as intersecting
+    bool intersectsAABB(const glm::vec3& _min, const glm::vec3& _max) const;
+
+private:
+    glm::vec4 m_planes[count];
+};
+
+} // OGLW
@@ -1,4 +1,5 @@
 #include "geometries.h"
+#include "core/geometryProcessing.h"
 
 
 namespace OGLW {
@@ -10,6 +11,7 @@ std::unique_ptr<RawMesh> cube(float _size) {
         {"color", 3, GL_FLOAT, false, 0, AttributeLocation::color},
         {"normal", 3, GL_FLOAT, false, 0, AttributeLocation::normal},
         {"uv", 2, GL_FLOAT, false, 0, AttributeLocation::uv},
+        {"tangent", 4, GL_FLOAT, false, 0, AttributeLocation::tangent},
     }));
 
     auto mesh = std::unique_ptr<RawMesh>(new RawMesh(layout, GL_TRIANGLES));
@@ -35,6 +37,22 @@ std::unique_ptr<RawMesh> cube(float _size) {
     vertices.push_back({{-1.0 * _size,  1.0 * _size, -1.0 * _size}});
     vertices.push_back({{ 1.0 * _size,  1.0 * _size, -1.0 * _size}});
 
+    Vec3Array positions;
+    Vec3Array normals;
+    positions.resize(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        positions.x[i] = vertices[i].position.x;
+        positions.y[i] = vertices[i].position.y;
+        positions.z[i] = vertices[i].position.z;
+    }
+
+    computeNormals(positions, std::vector<GLuint>(indices.begin(), indices.end()), normals);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].normal = glm::vec3(normals.x[i], normals.y[i], normals.z[i]);
+    }
+
     mesh->addVertices(std::move(vertices), std::move(indices));
     return std::move(mesh);
 }
@@ -72,46 +90,35 @@ std::unique_ptr<Mesh<glm::vec4>> plane(float _width, float _height, uint _nw, ui
 
     auto mesh = std::unique_ptr<Mesh<glm::vec4>>(new Mesh<glm::vec4>(layout, GL_TRIANGLES));
 
-    std::vector<glm::vec4> vertices;
-    std::vector<int> indices;
-
-    int indexOffset = 0;
-
-    float rw = 1.f / _width;
-    float rh = 1.f / _height;
-    float ow = _width / _nw;
-    float oh = _height / _nh;
+    // one vertex per grid point, computed from the integer grid coordinates so that the corners
+    // shared by neighbouring cells are the same vertex
+    mesh->reserve((_nw + 1) * (_nh + 1), _nw * _nh * 6);
+    mesh->beginSubmesh();
 
-    float ou = ow * rw;
-    float ov = oh * rh;
+    for (uint i = 0; i <= _nw; ++i) {
+        for (uint j = 0; j <= _nh; ++j) {
+            float u = float(i) / _nw;
+            float v = float(j) / _nh;
 
-    for (float w = -_width / 2.0; w < _width / 2.0; w += ow) {
-        for (float h = -_height / 2.0; h < _height / 2.0; h += oh) {
-            float u = (w + _width / 2.0) * rw;
-            float v = (h + _height / 2.0) * rh;
-
-            glm::vec4 v0 = {w, h + oh, u, v + ov};
-            glm::vec4 v1 = {w, h, u, v};
-            glm::vec4 v2 = {w + ow, h, u + ou, v};
-            glm::vec4 v3 = {w + ow, h + oh, u + ou, v + ov};
-
-            vertices.push_back(v0);
-            vertices.push_back(v1);
-            vertices.push_back(v2);
-            vertices.push_back(v3);
-
-            indices.push_back(indexOffset + 0);
-            indices.push_back(indexOffset + 1);
-            indices.push_back(indexOffset + 2);
-            indices.push_back(indexOffset + 0);
-            indices.push_back(indexOffset + 2);
-            indices.push_back(indexOffset + 3);
-
-            indexOffset += 4;
+            mesh->addVertex({(u - 0.5f) * _width, (v - 0.5f) * _height, u, v});
         }
     }
 
-    mesh->addVertices(std::move(vertices), std::move(indices));
+    for (uint i = 0; i < _nw; ++i) {
+        for (uint j = 0; j < _nh; ++j) {
+            int bottomLeft = i * (_nh + 1) + j;
+            int topLeft = bottomLeft + 1;
+            int bottomRight = bottomLeft + _nh + 1;
+            int topRight = bottomRight + 1;
+
+            mesh->addIndex(topLeft);
+            mesh->addIndex(bottomLeft);
+            mesh->addIndex(bottomRight);
+            mesh->addIndex(topLeft);
+            mesh->addIndex(bottomRight);
+            mesh->addIndex(topRight);
+        }
+    }
 
     return std::move(mesh);
 }
@@ -0,0 +1,377 @@
+#include "geometryProcessing.h"
+#include "core/parallel.h"
+#include <cmath>
+#include <numeric>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace OGLW {
+
+namespace {
+
+// triangles and vertices processed by a thread at least
+const size_t grainSize = 1 << 14;
+
+// corners of the triangles around each vertex, in index order
+struct VertexCorners {
+    std::vector<GLuint> offsets;
+    std::vector<GLuint> corners;
+};
+
+// per face data, one entry per triangle
+struct FaceData {
+    Vec3Array vectors;
+    Vec3Array secondaryVectors;
+    // angle of each corner, three per triangle
+    std::vector<float> angles;
+};
+
+} // anonymous
+
+static VertexCorners buildVertexCorners(const std::vector<GLuint>& _indices, size_t _nVertices) {
+    VertexCorners adjacency;
+
+    adjacency.offsets.assign(_nVertices + 1, 0);
+    adjacency.corners.resize(_indices.size());
+
+    for (GLuint index : _indices) {
+        adjacency.offsets[index + 1]++;
+    }
+
+    std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+    std::vector<GLuint> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < _indices.size(); ++i) {
+        adjacency.corners[fill[_indices[i]]++] = i;
+    }
+
+    return adjacency;
+}
+
+static inline float safeAcos(float _cos) {
+    return std::acos(std::max(-1.0f, std::min(1.0f, _cos)));
+}
+
+// corner angles of a triangle from its edges e01 = p1 - p0, e02 = p2 - p0 and e12 = p2 - p1
+static inline void cornerAngles(const float* _e01, const float* _e02, const float* _e12, float* _angles) {
+    auto dot = [](const float* _a, const float* _b) { return _a[0] * _b[0] + _a[1] * _b[1] + _a[2] * _b[2]; };
+
+    float l01 = std::sqrt(dot(_e01, _e01));
+    float l02 = std::sqrt(dot(_e02, _e02));
+    float l12 = std::sqrt(dot(_e12, _e12));
+
+    if (l01 == 0.0f || l02 == 0.0f || l12 == 0.0f) {
+        _angles[0] = _angles[1] = _angles[2] = 0.0f;
+        return;
+    }
+
+    _angles[0] = safeAcos(dot(_e01, _e02) / (l01 * l02));
+    _angles[1] = safeAcos(-dot(_e01, _e12) / (l01 * l12));
+    _angles[2] = float(M_PI) - _angles[0] - _angles[1];
+}
+
+static void computeFaceNormals(const Vec3Array& _p, const std::vector<GLuint>& _indices, size_t _begin, size_t _end,
+    FaceData& _faces)
+{
+    const GLuint* indices = _indices.data();
+    Vec3Array& normals = _faces.vectors;
+    size_t t = _begin;
+
+#if defined(__SSE2__)
+    for (; t + 4 <= _end; t += 4) {
+        const GLuint* i = indices + t * 3;
+
+        __m128 p0x = _mm_setr_ps(_p.x[i[0]], _p.x[i[3]], _p.x[i[6]], _p.x[i[9]]);
+        __m128 p0y = _mm_setr_ps(_p.y[i[0]], _p.y[i[3]], _p.y[i[6]], _p.y[i[9]]);
+        __m128 p0z = _mm_setr_ps(_p.z[i[0]], _p.z[i[3]], _p.z[i[6]], _p.z[i[9]]);
+        __m128 e1x = _mm_sub_ps(_mm_setr_ps(_p.x[i[1]], _p.x[i[4]], _p.x[i[7]], _p.x[i[10]]), p0x);
+        __m128 e1y = _mm_sub_ps(_mm_setr_ps(_p.y[i[1]], _p.y[i[4]], _p.y[i[7]], _p.y[i[10]]), p0y);
+        __m128 e1z = _mm_sub_ps(_mm_setr_ps(_p.z[i[1]], _p.z[i[4]], _p.z[i[7]], _p.z[i[10]]), p0z);
+        __m128 e2x = _mm_sub_ps(_mm_setr_ps(_p.x[i[2]], _p.x[i[5]], _p.x[i[8]], _p.x[i[11]]), p0x);
+        __m128 e2y = _mm_sub_ps(_mm_setr_ps(_p.y[i[2]], _p.y[i[5]], _p.y[i[8]], _p.y[i[11]]), p0y);
+        __m128 e2z = _mm_sub_ps(_mm_setr_ps(_p.z[i[2]], _p.z[i[5]], _p.z[i[8]], _p.z[i[11]]), p0z);
+
+        // the length of the cross product is twice the area of the triangle
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+
+        _mm_storeu_ps(&normals.x[t], nx);
+        _mm_storeu_ps(&normals.y[t], ny);
+        _mm_storeu_ps(&normals.z[t], nz);
+    }
+#endif
+
+    for (; t < _end; ++t) {
+        const GLuint* i = indices + t * 3;
+        float e1[3] = { _p.x[i[1]] - _p.x[i[0]], _p.y[i[1]] - _p.y[i[0]], _p.z[i[1]] - _p.z[i[0]] };
+        float e2[3] = { _p.x[i[2]] - _p.x[i[0]], _p.y[i[2]] - _p.y[i[0]], _p.z[i[2]] - _p.z[i[0]] };
+
+        normals.x[t] = e1[1] * e2[2] - e1[2] * e2[1];
+        normals.y[t] = e1[2] * e2[0] - e1[0] * e2[2];
+        normals.z[t] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    if (_faces.angles.empty()) {
+        return;
+    }
+
+    for (t = _begin; t < _end; ++t) {
+        const GLuint* i = indices + t * 3;
+        float e01[3] = { _p.x[i[1]] - _p.x[i[0]], _p.y[i[1]] - _p.y[i[0]], _p.z[i[1]] - _p.z[i[0]] };
+        float e02[3] = { _p.x[i[2]] - _p.x[i[0]], _p.y[i[2]] - _p.y[i[0]], _p.z[i[2]] - _p.z[i[0]] };
+        float e12[3] = { _p.x[i[2]] - _p.x[i[1]], _p.y[i[2]] - _p.y[i[1]], _p.z[i[2]] - _p.z[i[1]] };
+
+        cornerAngles(e01, e02, e12, &_faces.angles[t * 3]);
+    }
+}
+
+// normalize the vectors in [_begin, _end), null vectors are left untouched
+static void normalize(Vec3Array& _v, size_t _begin, size_t _end) {
+    size_t i = _begin;
+
+#if defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= _end; i += 4) {
+        __m128 x = _mm_loadu_ps(&_v.x[i]);
+        __m128 y = _mm_loadu_ps(&_v.y[i]);
+        __m128 z = _mm_loadu_ps(&_v.z[i]);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        __m128 valid = _mm_cmpgt_ps(length, zero);
+        __m128 scale = _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(one, length)), _mm_andnot_ps(valid, one));
+
+        _mm_storeu_ps(&_v.x[i], _mm_mul_ps(x, scale));
+        _mm_storeu_ps(&_v.y[i], _mm_mul_ps(y, scale));
+        _mm_storeu_ps(&_v.z[i], _mm_mul_ps(z, scale));
+    }
+#endif
+
+    for (; i < _end; ++i) {
+        float length = std::sqrt(_v.x[i] * _v.x[i] + _v.y[i] * _v.y[i] + _v.z[i] * _v.z[i]);
+
+        if (length > 0.0f) {
+            _v.x[i] /= length;
+            _v.y[i] /= length;
+            _v.z[i] /= length;
+        }
+    }
+}
+
+void computeNormals(const Vec3Array& _positions, const std::vector<GLuint>& _indices, Vec3Array& _normals,
+    NormalWeighting _weighting)
+{
+    size_t nVertices = _positions.size();
+    size_t nTriangles = _indices.size() / 3;
+    bool angleWeighted = _weighting == NormalWeighting::angle;
+
+    FaceData faces;
+    faces.vectors.resize(nTriangles);
+    if (angleWeighted) {
+        faces.angles.resize(nTriangles * 3);
+    }
+
+    parallelFor(0, nTriangles, grainSize, [&](size_t _begin, size_t _end) {
+        computeFaceNormals(_positions, _indices, _begin, _end, faces);
+
+        // angle weighted contributions use unit face normals
+        if (angleWeighted) {
+            normalize(faces.vectors, _begin, _end);
+        }
+    });
+
+    VertexCorners adjacency = buildVertexCorners(_indices, nVertices);
+
+    _normals.resize(nVertices);
+
+    parallelFor(0, nVertices, grainSize, [&](size_t _begin, size_t _end) {
+        for (size_t v = _begin; v < _end; ++v) {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+
+            for (GLuint c = adjacency.offsets[v]; c < adjacency.offsets[v + 1]; ++c) {
+                GLuint corner = adjacency.corners[c];
+                GLuint t = corner / 3;
+                float weight = angleWeighted ? faces.angles[corner] : 1.0f;
+
+                x += faces.vectors.x[t] * weight;
+                y += faces.vectors.y[t] * weight;
+                z += faces.vectors.z[t] * weight;
+            }
+
+            _normals.x[v] = x;
+            _normals.y[v] = y;
+            _normals.z[v] = z;
+        }
+
+        normalize(_normals, _begin, _end);
+    });
+}
+
+static void computeFaceTangents(const Vec3Array& _p, const Vec2Array& _uv, const std::vector<GLuint>& _indices,
+    size_t _begin, size_t _end, FaceData& _faces)
+{
+    const GLuint* indices = _indices.data();
+    Vec3Array& tangents = _faces.vectors;
+    Vec3Array& bitangents = _faces.secondaryVectors;
+    size_t t = _begin;
+
+#if defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    for (; t + 4 <= _end; t += 4) {
+        const GLuint* i = indices + t * 3;
+
+        __m128 p0x = _mm_setr_ps(_p.x[i[0]], _p.x[i[3]], _p.x[i[6]], _p.x[i[9]]);
+        __m128 p0y = _mm_setr_ps(_p.y[i[0]], _p.y[i[3]], _p.y[i[6]], _p.y[i[9]]);
+        __m128 p0z = _mm_setr_ps(_p.z[i[0]], _p.z[i[3]], _p.z[i[6]], _p.z[i[9]]);
+        __m128 e1x = _mm_sub_ps(_mm_setr_ps(_p.x[i[1]], _p.x[i[4]], _p.x[i[7]], _p.x[i[10]]), p0x);
+        __m128 e1y = _mm_sub_ps(_mm_setr_ps(_p.y[i[1]], _p.y[i[4]], _p.y[i[7]], _p.y[i[10]]), p0y);
+        __m128 e1z = _mm_sub_ps(_mm_setr_ps(_p.z[i[1]], _p.z[i[4]], _p.z[i[7]], _p.z[i[10]]), p0z);
+        __m128 e2x = _mm_sub_ps(_mm_setr_ps(_p.x[i[2]], _p.x[i[5]], _p.x[i[8]], _p.x[i[11]]), p0x);
+        __m128 e2y = _mm_sub_ps(_mm_setr_ps(_p.y[i[2]], _p.y[i[5]], _p.y[i[8]], _p.y[i[11]]), p0y);
+        __m128 e2z = _mm_sub_ps(_mm_setr_ps(_p.z[i[2]], _p.z[i[5]], _p.z[i[8]], _p.z[i[11]]), p0z);
+
+        __m128 u0 = _mm_setr_ps(_uv.x[i[0]], _uv.x[i[3]], _uv.x[i[6]], _uv.x[i[9]]);
+        __m128 v0 = _mm_setr_ps(_uv.y[i[0]], _uv.y[i[3]], _uv.y[i[6]], _uv.y[i[9]]);
+        __m128 du1 = _mm_sub_ps(_mm_setr_ps(_uv.x[i[1]], _uv.x[i[4]], _uv.x[i[7]], _uv.x[i[10]]), u0);
+        __m128 dv1 = _mm_sub_ps(_mm_setr_ps(_uv.y[i[1]], _uv.y[i[4]], _uv.y[i[7]], _uv.y[i[10]]), v0);
+        __m128 du2 = _mm_sub_ps(_mm_setr_ps(_uv.x[i[2]], _uv.x[i[5]], _uv.x[i[8]], _uv.x[i[11]]), u0);
+        __m128 dv2 = _mm_sub_ps(_mm_setr_ps(_uv.y[i[2]], _uv.y[i[5]], _uv.y[i[8]], _uv.y[i[11]]), v0);
+
+        // only the orientation of the uv mapping matters, degenerate mappings don't contribute
+        __m128 area = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+        __m128 valid = _mm_cmpneq_ps(area, zero);
+        __m128 sign = _mm_and_ps(valid, _mm_or_ps(_mm_and_ps(area, signMask), _mm_set1_ps(1.0f)));
+
+        __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1x, dv2), _mm_mul_ps(e2x, dv1)), sign);
+        __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1y, dv2), _mm_mul_ps(e2y, dv1)), sign);
+        __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1z, dv2), _mm_mul_ps(e2z, dv1)), sign);
+        __m128 bx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2x, du1), _mm_mul_ps(e1x, du2)), sign);
+        __m128 by = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2y, du1), _mm_mul_ps(e1y, du2)), sign);
+        __m128 bz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2z, du1), _mm_mul_ps(e1z, du2)), sign);
+
+        _mm_storeu_ps(&tangents.x[t], tx);
+        _mm_storeu_ps(&tangents.y[t], ty);
+        _mm_storeu_ps(&tangents.z[t], tz);
+        _mm_storeu_ps(&bitangents.x[t], bx);
+        _mm_storeu_ps(&bitangents.y[t], by);
+        _mm_storeu_ps(&bitangents.z[t], bz);
+    }
+#endif
+
+    for (; t < _end; ++t) {
+        const GLuint* i = indices + t * 3;
+        float e1[3] = { _p.x[i[1]] - _p.x[i[0]], _p.y[i[1]] - _p.y[i[0]], _p.z[i[1]] - _p.z[i[0]] };
+        float e2[3] = { _p.x[i[2]] - _p.x[i[0]], _p.y[i[2]] - _p.y[i[0]], _p.z[i[2]] - _p.z[i[0]] };
+        float du1 = _uv.x[i[1]] - _uv.x[i[0]];
+        float dv1 = _uv.y[i[1]] - _uv.y[i[0]];
+        float du2 = _uv.x[i[2]] - _uv.x[i[0]];
+        float dv2 = _uv.y[i[2]] - _uv.y[i[0]];
+        float area = du1 * dv2 - du2 * dv1;
+        float sign = area > 0.0f ? 1.0f : (area < 0.0f ? -1.0f : 0.0f);
+
+        tangents.x[t] = (e1[0] * dv2 - e2[0] * dv1) * sign;
+        tangents.y[t] = (e1[1] * dv2 - e2[1] * dv1) * sign;
+        tangents.z[t] = (e1[2] * dv2 - e2[2] * dv1) * sign;
+        bitangents.x[t] = (e2[0] * du1 - e1[0] * du2) * sign;
+        bitangents.y[t] = (e2[1] * du1 - e1[1] * du2) * sign;
+        bitangents.z[t] = (e2[2] * du1 - e1[2] * du2) * sign;
+    }
+
+    for (t = _begin; t < _end; ++t) {
+        const GLuint* i = indices + t * 3;
+        float e01[3] = { _p.x[i[1]] - _p.x[i[0]], _p.y[i[1]] - _p.y[i[0]], _p.z[i[1]] - _p.z[i[0]] };
+        float e02[3] = { _p.x[i[2]] - _p.x[i[0]], _p.y[i[2]] - _p.y[i[0]], _p.z[i[2]] - _p.z[i[0]] };
+        float e12[3] = { _p.x[i[2]] - _p.x[i[1]], _p.y[i[2]] - _p.y[i[1]], _p.z[i[2]] - _p.z[i[1]] };
+
+        cornerAngles(e01, e02, e12, &_faces.angles[t * 3]);
+    }
+}
+
+void computeTangents(const Vec3Array& _positions, const Vec3Array& _normals, const Vec2Array& _uvs,
+    const std::vector<GLuint>& _indices, Vec3Array& _tangents, std::vector<float>& _handedness)
+{
+    size_t nVertices = _positions.size();
+    size_t nTriangles = _indices.size() / 3;
+
+    FaceData faces;
+    faces.vectors.resize(nTriangles);
+    faces.secondaryVectors.resize(nTriangles);
+    faces.angles.resize(nTriangles * 3);
+
+    parallelFor(0, nTriangles, grainSize, [&](size_t _begin, size_t _end) {
+        computeFaceTangents(_positions, _uvs, _indices, _begin, _end, faces);
+        normalize(faces.vectors, _begin, _end);
+        normalize(faces.secondaryVectors, _begin, _end);
+    });
+
+    VertexCorners adjacency = buildVertexCorners(_indices, nVertices);
+
+    _tangents.resize(nVertices);
+    _handedness.resize(nVertices);
+
+    parallelFor(0, nVertices, grainSize, [&](size_t _begin, size_t _end) {
+        for (size_t v = _begin; v < _end; ++v) {
+            float n[3] = { _normals.x[v], _normals.y[v], _normals.z[v] };
+            float tangent[3] = { 0.0f, 0.0f, 0.0f };
+            float bitangent[3] = { 0.0f, 0.0f, 0.0f };
+
+            for (GLuint c = adjacency.offsets[v]; c < adjacency.offsets[v + 1]; ++c) {
+                GLuint corner = adjacency.corners[c];
+                GLuint t = corner / 3;
+                float ft[3] = { faces.vectors.x[t], faces.vectors.y[t], faces.vectors.z[t] };
+                float fb[3] = { faces.secondaryVectors.x[t], faces.secondaryVectors.y[t],
+                    faces.secondaryVectors.z[t] };
+
+                // project the face frame on the tangent plane of the vertex before weighting it
+                float dt = n[0] * ft[0] + n[1] * ft[1] + n[2] * ft[2];
+                float db = n[0] * fb[0] + n[1] * fb[1] + n[2] * fb[2];
+                float pt[3] = { ft[0] - n[0] * dt, ft[1] - n[1] * dt, ft[2] - n[2] * dt };
+                float pb[3] = { fb[0] - n[0] * db, fb[1] - n[1] * db, fb[2] - n[2] * db };
+                float lt = std::sqrt(pt[0] * pt[0] + pt[1] * pt[1] + pt[2] * pt[2]);
+                float lb = std::sqrt(pb[0] * pb[0] + pb[1] * pb[1] + pb[2] * pb[2]);
+                float weight = faces.angles[corner];
+
+                for (int k = 0; k < 3; ++k) {
+                    tangent[k] += lt > 0.0f ? pt[k] / lt * weight : 0.0f;
+                    bitangent[k] += lb > 0.0f ? pb[k] / lb * weight : 0.0f;
+                }
+            }
+
+            // make sure the tangent stays in the normal plane after the accumulation
+            float d = n[0] * tangent[0] + n[1] * tangent[1] + n[2] * tangent[2];
+            for (int k = 0; k < 3; ++k) {
+                tangent[k] -= n[k] * d;
+            }
+
+            if (tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2] == 0.0f) {
+                // no usable uv mapping around the vertex, any vector orthogonal to the normal
+                bool useX = std::abs(n[0]) < 0.9f;
+                float axis[3] = { useX ? 1.0f : 0.0f, useX ? 0.0f : 1.0f, 0.0f };
+                float da = n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2];
+                for (int k = 0; k < 3; ++k) {
+                    tangent[k] = axis[k] - n[k] * da;
+                }
+            }
+
+            // the bitangent is reconstructed as cross(n, t) * handedness
+            float c[3] = {
+                n[1] * tangent[2] - n[2] * tangent[1],
+                n[2] * tangent[0] - n[0] * tangent[2],
+                n[0] * tangent[1] - n[1] * tangent[0]
+            };
+
+            _tangents.x[v] = tangent[0];
+            _tangents.y[v] = tangent[1];
+            _tangents.z[v] = tangent[2];
+            _handedness[v] = c[0] * bitangent[0] + c[1] * bitangent[1] + c[2] * bitangent[2] < 0.0f ? -1.0f : 1.0f;
+        }
+
+        normalize(_tangents, _begin, _end);
+    });
+}
+
+} // OGLW
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "gl/glTypes.h"
+#include "core/types.h"
+
+namespace OGLW {
+
+// Vertex attribute generation over indexed triangle lists. Attributes are stored as one array
+// per component so that four vertices or triangles are processed at once with SSE, the work is
+// split across threads by ranges of triangles then vertices. Each vertex gathers the contributions
+// of its triangles in index order, so the results don't depend on the number of threads.
+
+// two component vectors stored as one array per component
+struct Vec2Array {
+    std::vector<float> x;
+    std::vector<float> y;
+
+    void resize(size_t _size) { x.resize(_size); y.resize(_size); }
+    size_t size() const { return x.size(); }
+};
+
+// three component vectors stored as one array per component
+struct Vec3Array {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    void resize(size_t _size) { x.resize(_size); y.resize(_size); z.resize(_size); }
+    size_t size() const { return x.size(); }
+};
+
+enum class NormalWeighting {
+    // faces contribute proportionally to their area
+    area,
+    // faces contribute proportionally to their angle at the vertex, independent of the tessellation
+    angle
+};
+
+// compute smooth vertex normals, vertices not referenced by any triangle get a null normal
+void computeNormals(const Vec3Array& _positions, const std::vector<GLuint>& _indices, Vec3Array& _normals,
+    NormalWeighting _weighting = NormalWeighting::angle);
+
+// compute vertex tangents following the MikkTSpace conventions: per face tangents projected on the
+// vertex normal plane, angle weighted, and the bitangent given by _handedness * cross(normal, tangent).
+// vertices aren't split on tangent space discontinuities, their tangents are averaged
+void computeTangents(const Vec3Array& _positions, const Vec3Array& _normals, const Vec2Array& _uvs,
+    const std::vector<GLuint>& _indices, Vec3Array& _tangents, std::vector<float>& _handedness);
+
+} // OGLW
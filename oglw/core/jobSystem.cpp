@@ -0,0 +1,255 @@
+#include "jobSystem.h"
+
+namespace OGLW {
+
+// index of the worker running on the calling thread, -1 outside of the workers
+static thread_local int workerIndex = -1;
+// the scheduler the calling worker belongs to
+static thread_local JobSystem* workerSystem = nullptr;
+
+JobSystem::JobSystem(uint _workers) :
+    m_nextWorker(0),
+    m_queuedJobs(0),
+    m_running(true),
+    m_mainThread(std::this_thread::get_id())
+{
+    if (_workers == 0) {
+        _workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    // at least one worker so that jobs run even when nobody waits on them
+    _workers = std::max(1u, _workers);
+
+    for (uint i = 0; i < _workers; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    // the workers are started once all the deques exist, they steal from each other
+    for (uint i = 0; i < _workers; ++i) {
+        m_workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_running = false;
+    }
+
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+JobSystem& JobSystem::get() {
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+void JobSystem::run(Job _job, JobCounter* _counter, JobCounter* _dependency) {
+    if (_counter) {
+        _counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (_dependency) {
+        std::lock_guard<std::mutex> lock(_dependency->m_mutex);
+
+        // the dependents are released by the job bringing the counter to zero, under the same lock
+        if (!_dependency->done()) {
+            _dependency->m_dependents.push_back({ std::move(_job), _counter });
+            return;
+        }
+    }
+
+    submit({ std::move(_job), _counter });
+}
+
+void JobSystem::runOnMainThread(Job _job, JobCounter* _counter) {
+    if (_counter) {
+        _counter->m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+        m_mainThreadJobs.push_back({ std::move(_job), _counter });
+    }
+
+    {
+        // the main thread may be waiting on a counter this job decrements
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+
+    m_wake.notify_all();
+}
+
+bool JobSystem::hasMainThreadJobs() {
+    std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+    return !m_mainThreadJobs.empty();
+}
+
+void JobSystem::runMainThreadJobs() {
+    std::vector<JobCounter::PendingJob> jobs;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mainThreadMutex);
+        jobs.swap(m_mainThreadJobs);
+    }
+
+    // jobs queued by these ones run on the next call
+    for (auto& job : jobs) {
+        execute(job);
+    }
+}
+
+void JobSystem::submit(JobCounter::PendingJob _job) {
+    Worker* worker;
+
+    if (workerSystem == this) {
+        worker = m_workers[workerIndex].get();
+    } else {
+        worker = m_workers[m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size()].get();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->jobs.push_back(std::move(_job));
+    }
+
+    {
+        // taken so that a worker can't miss the wake up between its check and its wait
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queuedJobs.fetch_add(1, std::memory_order_release);
+    }
+
+    m_wake.notify_one();
+}
+
+bool JobSystem::findJob(JobCounter::PendingJob& _job) {
+    uint nWorkers = m_workers.size();
+    uint self = workerSystem == this ? workerIndex : 0;
+
+    // the most recent job of the own deque is the most likely to be in cache
+    if (workerSystem == this) {
+        Worker& worker = *m_workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+
+        if (!worker.jobs.empty()) {
+            _job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // the oldest jobs of the other deques are the largest ones left by recursive splits
+    for (uint i = 0; i < nWorkers; ++i) {
+        Worker& victim = *m_workers[(self + i) % nWorkers];
+
+        if (workerSystem == this && &victim == m_workers[self].get()) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.jobs.empty()) {
+            _job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::execute(JobCounter::PendingJob& _job) {
+    _job.job();
+
+    JobCounter* counter = _job.counter;
+
+    if (!counter) {
+        return;
+    }
+
+    std::vector<JobCounter::PendingJob> dependents;
+
+    bool done = false;
+
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+
+        if (counter->m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            dependents.swap(counter->m_dependents);
+            done = true;
+        }
+    }
+
+    for (auto& dependent : dependents) {
+        submit(std::move(dependent));
+    }
+
+    if (done) {
+        {
+            // taken so that a waiting thread can't miss the wake up between its check and its wait,
+            // the counter itself may be destroyed as soon as it reached zero
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+
+        m_wake.notify_all();
+    }
+}
+
+void JobSystem::wait(JobCounter& _counter) {
+    JobCounter::PendingJob job;
+    // the jobs queued for the main thread may be the ones the counter waits for
+    bool mainThread = std::this_thread::get_id() == m_mainThread;
+
+    while (!_counter.done()) {
+        if (findJob(job)) {
+            execute(job);
+            continue;
+        }
+
+        if (mainThread && hasMainThreadJobs()) {
+            runMainThreadJobs();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [&]() {
+            return _counter.done() || m_queuedJobs.load(std::memory_order_acquire) > 0
+                || (mainThread && hasMainThreadJobs());
+        });
+    }
+
+    // the job bringing the counter to zero may still hold its lock, the counter can only be
+    // destroyed once released
+    std::lock_guard<std::mutex> lock(_counter.m_mutex);
+}
+
+void JobSystem::workerLoop(uint _index) {
+    workerIndex = _index;
+    workerSystem = this;
+
+    JobCounter::PendingJob job;
+
+    while (true) {
+        if (findJob(job)) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() {
+            return !m_running || m_queuedJobs.load(std::memory_order_acquire) > 0;
+        });
+
+        if (!m_running) {
+            break;
+        }
+    }
+}
+
+} // OGLW
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "core/types.h"
+
+namespace OGLW {
+
+class JobSystem;
+
+// A count of unfinished jobs. A counter is incremented when a job is submitted with it and
+// decremented once the job ran, it can be waited on or used as the dependency of other jobs.
+// It must outlive the jobs referring to it and be waited on before being destroyed.
+class JobCounter {
+public:
+    JobCounter() : m_count(0) {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    // whether all the jobs submitted with the counter ran
+    bool done() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    struct PendingJob {
+        std::function<void()> job;
+        JobCounter* counter;
+    };
+
+    std::atomic<int> m_count;
+    std::mutex m_mutex;
+    // jobs waiting for the counter to reach zero
+    std::vector<PendingJob> m_dependents;
+};
+
+// A work stealing thread pool shared by the library. Each worker owns a deque, the jobs it
+// submits are pushed to and popped from the back of its own deque, other threads submit to the
+// workers in turn, and idle workers steal the oldest jobs from the front of the other deques.
+// Threads waiting on a counter run jobs in the meantime, so parallel loops can be nested, and sleep
+// when there is none left. Jobs touching GL are queued for the main thread, which runs them once per
+// frame and while it waits. The thread constructing the scheduler is the main thread.
+class JobSystem {
+public:
+    typedef std::function<void()> Job;
+
+    // _workers 0 starts one worker per hardware thread but the calling one
+    JobSystem(uint _workers = 0);
+    ~JobSystem();
+
+    // get the scheduler shared by the library, started on first use
+    static JobSystem& get();
+
+    // run _job on a worker, once _dependency reached zero when given, _counter is incremented
+    // right away and decremented once the job ran
+    void run(Job _job, JobCounter* _counter = nullptr, JobCounter* _dependency = nullptr);
+    // run _job on the main thread during the next call to runMainThreadJobs()
+    void runOnMainThread(Job _job, JobCounter* _counter = nullptr);
+    // run the jobs queued for the main thread, called once per frame by the app
+    void runMainThreadJobs();
+    // return once _counter reached zero, running other jobs meanwhile, including the jobs queued for
+    // the main thread when called from it
+    void wait(JobCounter& _counter);
+
+    // split [_begin, _end) in contiguous ranges of at least _grain elements and call _fn(begin, end)
+    // on each of them concurrently, the calling thread runs the first range and helps with the
+    // others until all of them are done
+    template <typename Fn>
+    void parallelFor(size_t _begin, size_t _end, size_t _grain, const Fn& _fn);
+
+    // number of worker threads
+    uint getWorkerCount() const { return m_workers.size(); }
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<JobCounter::PendingJob> jobs;
+    };
+
+    // queue a job whose dependencies are met
+    void submit(JobCounter::PendingJob _job);
+    // pop a job from the deque of the calling worker, or steal one from another worker
+    bool findJob(JobCounter::PendingJob& _job);
+    // run a job and release the jobs depending on its counter
+    void execute(JobCounter::PendingJob& _job);
+    // whether jobs are queued for the main thread
+    bool hasMainThreadJobs();
+    void workerLoop(uint _index);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    // worker the next job submitted from outside the workers goes to
+    std::atomic<uint> m_nextWorker;
+    // jobs queued in the worker deques
+    std::atomic<int> m_queuedJobs;
+    std::atomic<bool> m_running;
+    // idle workers and waiting threads sleep on m_wake, woken up when a job is queued, or a counter
+    // reaches zero, or a job is queued for the main thread
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+
+    std::thread::id m_mainThread;
+    std::mutex m_mainThreadMutex;
+    std::vector<JobCounter::PendingJob> m_mainThreadJobs;
+};
+
+template <typename Fn>
+void JobSystem::parallelFor(size_t _begin, size_t _end, size_t _grain, const Fn& _fn) {
+    if (_end <= _begin) {
+        return;
+    }
+
+    size_t count = _end - _begin;
+    size_t nRanges = std::min<size_t>(m_workers.size() + 1, (count + _grain - 1) / std::max<size_t>(_grain, 1));
+
+    if (nRanges <= 1) {
+        _fn(_begin, _end);
+        return;
+    }
+
+    size_t rangeSize = (count + nRanges - 1) / nRanges;
+    JobCounter counter;
+
+    for (size_t start = _begin + rangeSize; start < _end; start += rangeSize) {
+        size_t end = std::min(start + rangeSize, _end);
+        run([&_fn, start, end]() { _fn(start, end); }, &counter);
+    }
+
+    _fn(_begin, std::min(_begin + rangeSize, _end));
+
+    wait(counter);
+}
+
+} // OGLW
@@ -0,0 +1,40 @@
+#include "mappedFile.h"
+#include "core/log.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace OGLW {
+
+MappedFile::MappedFile(const std::string& _path) : m_data(nullptr), m_size(0) {
+    int fd = open(_path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* data = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+        if (data != MAP_FAILED) {
+            m_data = static_cast<uchar*>(data);
+            m_size = info.st_size;
+        } else {
+            WARN("Failed to map file %s\n", _path.c_str());
+        }
+    }
+
+    // the mapping stays valid once the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+}
+
+} // OGLW
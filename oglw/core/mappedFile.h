@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include "core/types.h"
+
+namespace OGLW {
+
+// A file mapped in memory, the mapping is private so that writing to it copies the
+// touched pages instead of modifying the file
+class MappedFile {
+public:
+    MappedFile(const std::string& _path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // whether the file could be opened and mapped
+    bool isValid() const { return m_data != nullptr; }
+    // get the mapped file content
+    uchar* getData() const { return m_data; }
+    // get the size of the file in bytes
+    size_t getSize() const { return m_size; }
+
+private:
+    uchar* m_data;
+    size_t m_size;
+};
+
+} // OGLW
@@ -0,0 +1,308 @@
+#include "meshOptimizer.h"
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+namespace OGLW {
+
+static size_t hashVertex(const GLbyte* _vertex, size_t _stride) {
+    // FNV-1a
+    size_t hash = 2166136261u;
+
+    for (size_t i = 0; i < _stride; ++i) {
+        hash ^= (GLubyte)_vertex[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+size_t weldVertices(GLbyte* _vertices, size_t _nVertices, size_t _stride, std::vector<GLuint>& _indices) {
+    size_t tableSize = 1;
+    while (tableSize < _nVertices * 2) {
+        tableSize *= 2;
+    }
+
+    // open addressing table of unique vertex indices plus one, 0 marks an empty slot
+    std::vector<GLuint> table(tableSize, 0);
+    std::vector<GLuint> remap(_nVertices);
+    size_t nUnique = 0;
+
+    for (size_t v = 0; v < _nVertices; ++v) {
+        const GLbyte* vertex = _vertices + v * _stride;
+        size_t slot = hashVertex(vertex, _stride) & (tableSize - 1);
+
+        while (table[slot] != 0) {
+            const GLbyte* unique = _vertices + (table[slot] - 1) * _stride;
+            if (std::memcmp(unique, vertex, _stride) == 0) {
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] == 0) {
+            // unique vertices are compacted in place, the destination is never ahead of the source
+            if (nUnique != v) {
+                std::memcpy(_vertices + nUnique * _stride, vertex, _stride);
+            }
+            table[slot] = ++nUnique;
+        }
+
+        remap[v] = table[slot] - 1;
+    }
+
+    for (auto& index : _indices) {
+        index = remap[index];
+    }
+
+    return nUnique;
+}
+
+void optimizeVertexCache(std::vector<GLuint>& _indices, size_t _nVertices, uint _cacheSize,
+    std::vector<size_t>* _clusters)
+{
+    size_t nTriangles = _indices.size() / 3;
+
+    // vertex to triangles adjacency, compressed in a single array
+    std::vector<GLuint> adjacencyOffsets(_nVertices + 1, 0);
+    std::vector<GLuint> adjacency(nTriangles * 3);
+    // number of triangles not yet emitted per vertex
+    std::vector<int> liveTriangles(_nVertices, 0);
+
+    for (size_t i = 0; i < nTriangles * 3; ++i) {
+        liveTriangles[_indices[i]]++;
+    }
+
+    for (size_t v = 0; v < _nVertices; ++v) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+
+    std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+    for (size_t t = 0; t < nTriangles; ++t) {
+        for (int j = 0; j < 3; ++j) {
+            adjacency[fill[_indices[t * 3 + j]]++] = t;
+        }
+    }
+
+    std::vector<GLuint> output;
+    std::vector<int> cacheTime(_nVertices, 0);
+    std::vector<bool> emitted(nTriangles, false);
+    std::vector<GLuint> deadEnds;
+    std::vector<GLuint> candidates;
+
+    int time = _cacheSize + 1;
+    size_t cursor = 0;
+    int fanning = _nVertices > 0 ? 0 : -1;
+
+    output.reserve(nTriangles * 3);
+
+    // find the next vertex with live triangles when the candidates are exhausted
+    auto skipDeadEnd = [&]() -> int {
+        while (!deadEnds.empty()) {
+            GLuint vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                return vertex;
+            }
+        }
+
+        while (cursor < _nVertices) {
+            if (liveTriangles[cursor] > 0) {
+                return cursor;
+            }
+            cursor++;
+        }
+
+        return -1;
+    };
+
+    if (_clusters) {
+        _clusters->clear();
+    }
+
+    while (fanning >= 0) {
+        candidates.clear();
+
+        for (GLuint a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a) {
+            GLuint triangle = adjacency[a];
+
+            if (emitted[triangle]) {
+                continue;
+            }
+
+            for (int j = 0; j < 3; ++j) {
+                GLuint vertex = _indices[triangle * 3 + j];
+
+                output.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+
+                if (time - cacheTime[vertex] > (int)_cacheSize) {
+                    cacheTime[vertex] = time++;
+                }
+            }
+
+            emitted[triangle] = true;
+        }
+
+        // select the candidate that will still be in the cache when its fan is emitted
+        int next = -1;
+        int bestPriority = -1;
+
+        for (GLuint vertex : candidates) {
+            if (liveTriangles[vertex] <= 0) {
+                continue;
+            }
+
+            int priority = 0;
+            if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= (int)_cacheSize) {
+                priority = time - cacheTime[vertex];
+            }
+
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next < 0) {
+            next = skipDeadEnd();
+
+            // the ordering restarts from a vertex that may not be cached, start a new cluster
+            if (_clusters && next >= 0) {
+                _clusters->push_back(output.size());
+            }
+        }
+
+        fanning = next;
+    }
+
+    if (_clusters && (_clusters->empty() || _clusters->front() != 0)) {
+        _clusters->insert(_clusters->begin(), 0);
+    }
+
+    _indices.swap(output);
+}
+
+void optimizeOverdraw(std::vector<GLuint>& _indices, const std::vector<size_t>& _clusters,
+    const GLbyte* _vertices, size_t _stride, size_t _positionOffset, uint _positionSize)
+{
+    if (_clusters.size() < 2) {
+        return;
+    }
+
+    auto position = [&](GLuint _vertex) {
+        float p[3] = { 0.0, 0.0, 0.0 };
+        std::memcpy(p, _vertices + _vertex * _stride + _positionOffset, std::min(_positionSize, 3u) * sizeof(float));
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    struct Cluster {
+        size_t start;
+        size_t end;
+        float sortKey;
+    };
+
+    std::vector<Cluster> clusters;
+    std::vector<glm::vec3> centroids;
+    std::vector<glm::vec3> normals;
+    glm::vec3 meshCentroid(0.0);
+    float meshArea = 0.0;
+
+    for (size_t c = 0; c < _clusters.size(); ++c) {
+        size_t start = _clusters[c];
+        size_t end = c + 1 < _clusters.size() ? _clusters[c + 1] : _indices.size();
+        glm::vec3 centroid(0.0);
+        glm::vec3 normal(0.0);
+        float area = 0.0;
+
+        for (size_t i = start; i + 2 < end; i += 3) {
+            glm::vec3 p0 = position(_indices[i + 0]);
+            glm::vec3 p1 = position(_indices[i + 1]);
+            glm::vec3 p2 = position(_indices[i + 2]);
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float triangleArea = glm::length(n);
+
+            centroid += (p0 + p1 + p2) / 3.0f * triangleArea;
+            normal += n;
+            area += triangleArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+
+        clusters.push_back({ start, end, 0.0 });
+        centroids.push_back(area > 0.0 ? centroid / area : centroid);
+        normals.push_back(glm::length(normal) > 0.0 ? glm::normalize(normal) : normal);
+    }
+
+    if (meshArea > 0.0) {
+        meshCentroid /= meshArea;
+    }
+
+    // clusters far out of the mesh center and facing away from it are the most likely to occlude
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].sortKey = glm::dot(centroids[c] - meshCentroid, normals[c]);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& _a, const Cluster& _b) {
+        return _a.sortKey > _b.sortKey;
+    });
+
+    std::vector<GLuint> output;
+    output.reserve(_indices.size());
+
+    for (const auto& cluster : clusters) {
+        output.insert(output.end(), _indices.begin() + cluster.start, _indices.begin() + cluster.end);
+    }
+
+    _indices.swap(output);
+}
+
+size_t optimizeVertexFetch(GLbyte* _vertices, size_t _nVertices, size_t _stride, std::vector<GLuint>& _indices) {
+    const GLuint unused = ~0u;
+    std::vector<GLuint> remap(_nVertices, unused);
+    std::vector<GLbyte> vertices(_nVertices * _stride);
+    size_t nVertices = 0;
+
+    for (auto& index : _indices) {
+        if (remap[index] == unused) {
+            std::memcpy(vertices.data() + nVertices * _stride, _vertices + index * _stride, _stride);
+            remap[index] = nVertices++;
+        }
+        index = remap[index];
+    }
+
+    std::memcpy(_vertices, vertices.data(), nVertices * _stride);
+
+    return nVertices;
+}
+
+float computeACMR(const std::vector<GLuint>& _indices, size_t _nVertices, uint _cacheSize) {
+    size_t nTriangles = _indices.size() / 3;
+
+    if (nTriangles == 0) {
+        return 0.0;
+    }
+
+    // time at which each vertex entered the fifo, a vertex is cached while less than
+    // _cacheSize vertices entered after it
+    std::vector<size_t> entered(_nVertices, 0);
+    size_t time = _cacheSize + 1;
+    size_t misses = 0;
+
+    for (GLuint index : _indices) {
+        if (time - entered[index] > _cacheSize) {
+            entered[index] = time++;
+            misses++;
+        }
+    }
+
+    return float(misses) / nTriangles;
+}
+
+} // OGLW
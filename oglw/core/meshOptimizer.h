@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "gl/glTypes.h"
+#include "core/types.h"
+
+namespace OGLW {
+
+// Mesh optimization passes for indexed triangle lists, vertices are raw bytes of a given stride
+// and indices are relative to the first vertex.
+
+// weld the vertices with identical bytes, the unique vertices are moved to the front of _vertices
+// and _indices are remapped to them, returns the number of unique vertices
+size_t weldVertices(GLbyte* _vertices, size_t _nVertices, size_t _stride, std::vector<GLuint>& _indices);
+
+// reorder the triangles for the post transform vertex cache with Tipsify, _clusters receives
+// the first index of each cluster of triangles where the ordering had to restart
+void optimizeVertexCache(std::vector<GLuint>& _indices, size_t _nVertices, uint _cacheSize = 16,
+    std::vector<size_t>* _clusters = nullptr);
+
+// reorder the clusters from optimizeVertexCache so that clusters facing out of the mesh are drawn
+// first and occlude the ones behind them, positions are 2 or 3 floats at _positionOffset
+void optimizeOverdraw(std::vector<GLuint>& _indices, const std::vector<size_t>& _clusters,
+    const GLbyte* _vertices, size_t _stride, size_t _positionOffset, uint _positionSize);
+
+// reorder the vertices in the order they are first referenced and drop the unreferenced ones,
+// returns the number of referenced vertices
+size_t optimizeVertexFetch(GLbyte* _vertices, size_t _nVertices, size_t _stride, std::vector<GLuint>& _indices);
+
+// average cache miss ratio, the number of vertices transformed per triangle with a fifo cache
+float computeACMR(const std::vector<GLuint>& _indices, size_t _nVertices, uint _cacheSize = 16);
+
+} // OGLW
@@ -0,0 +1,271 @@
+#include "meshSimplifier.h"
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <numeric>
+#include <unordered_set>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+
+namespace OGLW {
+
+namespace {
+
+// sum of the squared distances to a set of planes, weighted by the area of the triangles they come from
+struct Quadric {
+    // upper triangle of the symmetric 4x4 matrix
+    double m[10] = {};
+    double weight = 0.0;
+
+    void addPlane(const glm::vec3& _n, double _d, double _weight) {
+        m[0] += _weight * _n.x * _n.x;
+        m[1] += _weight * _n.x * _n.y;
+        m[2] += _weight * _n.x * _n.z;
+        m[3] += _weight * _n.x * _d;
+        m[4] += _weight * _n.y * _n.y;
+        m[5] += _weight * _n.y * _n.z;
+        m[6] += _weight * _n.y * _d;
+        m[7] += _weight * _n.z * _n.z;
+        m[8] += _weight * _n.z * _d;
+        m[9] += _weight * _d * _d;
+        weight += _weight;
+    }
+
+    void add(const Quadric& _q) {
+        for (int i = 0; i < 10; ++i) {
+            m[i] += _q.m[i];
+        }
+        weight += _q.weight;
+    }
+
+    // average squared distance of _p to the planes
+    double error(const glm::vec3& _p) const {
+        double x = _p.x, y = _p.y, z = _p.z;
+        double e = m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x
+                 + m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y
+                 + m[7] * z * z + 2.0 * m[8] * z
+                 + m[9];
+
+        return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    GLuint from;
+    GLuint to;
+    float error;
+};
+
+} // anonymous
+
+static std::vector<glm::vec3> readPositions(const GLbyte* _vertices, size_t _nVertices, size_t _stride,
+    size_t _positionOffset, uint _positionSize)
+{
+    std::vector<glm::vec3> positions(_nVertices, glm::vec3(0.0f));
+
+    for (size_t v = 0; v < _nVertices; ++v) {
+        float p[3] = { 0.0f, 0.0f, 0.0f };
+        std::memcpy(p, _vertices + v * _stride + _positionOffset, std::min(_positionSize, 3u) * sizeof(float));
+        positions[v] = glm::vec3(p[0], p[1], p[2]);
+    }
+
+    return positions;
+}
+
+// the vertices of the edges without an opposite half edge can't be collapsed without opening cracks in the
+// mesh, those edges are the open borders and the attribute seams, where the triangles on each side use
+// different vertices at the same positions. the rest of the mesh, interior vertices next to a seam
+// included, stays free to collapse
+static std::vector<bool> findLockedVertices(const std::vector<GLuint>& _indices, size_t _nVertices) {
+    std::vector<bool> locked(_nVertices, false);
+
+    auto halfEdge = [](GLuint _a, GLuint _b) { return (uint64_t(_a) << 32) | _b; };
+    std::unordered_set<uint64_t> halfEdges;
+
+    halfEdges.reserve(_indices.size());
+    for (size_t i = 0; i + 2 < _indices.size(); i += 3) {
+        for (int j = 0; j < 3; ++j) {
+            halfEdges.insert(halfEdge(_indices[i + j], _indices[i + (j + 1) % 3]));
+        }
+    }
+
+    for (size_t i = 0; i + 2 < _indices.size(); i += 3) {
+        for (int j = 0; j < 3; ++j) {
+            GLuint a = _indices[i + j];
+            GLuint b = _indices[i + (j + 1) % 3];
+            if (halfEdges.count(halfEdge(b, a)) == 0) {
+                locked[a] = locked[b] = true;
+            }
+        }
+    }
+
+    return locked;
+}
+
+float simplifyMesh(const std::vector<GLuint>& _indices, const GLbyte* _vertices, size_t _nVertices, size_t _stride,
+    size_t _positionOffset, uint _positionSize, size_t _targetIndexCount, float _targetError,
+    std::vector<GLuint>& _destination)
+{
+    _destination = _indices;
+
+    auto positions = readPositions(_vertices, _nVertices, _stride, _positionOffset, _positionSize);
+    auto locked = findLockedVertices(_indices, _nVertices);
+
+    std::vector<Quadric> quadrics(_nVertices);
+
+    for (size_t i = 0; i + 2 < _indices.size(); i += 3) {
+        const glm::vec3& p0 = positions[_indices[i + 0]];
+        const glm::vec3& p1 = positions[_indices[i + 1]];
+        const glm::vec3& p2 = positions[_indices[i + 2]];
+        glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(n);
+
+        if (area == 0.0f) {
+            continue;
+        }
+
+        n /= area;
+
+        for (int j = 0; j < 3; ++j) {
+            quadrics[_indices[i + j]].addPlane(n, -glm::dot(n, p0), area * 0.5f);
+        }
+    }
+
+    std::vector<GLuint> remap(_nVertices);
+    std::vector<bool> touched(_nVertices);
+    std::vector<GLuint> triangleOffsets(_nVertices + 1);
+    std::vector<GLuint> vertexTriangles;
+    std::vector<Collapse> collapses;
+    double maxError = 0.0;
+    double targetError = double(_targetError) * double(_targetError);
+
+    // each pass collapses a set of independent edges, cheapest first
+    while (_destination.size() > _targetIndexCount) {
+        size_t nTriangles = _destination.size() / 3;
+
+        // triangles around each vertex
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (GLuint index : _destination) {
+            triangleOffsets[index + 1]++;
+        }
+        std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+        vertexTriangles.resize(_destination.size());
+        {
+            std::vector<GLuint> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (size_t i = 0; i < _destination.size(); ++i) {
+                vertexTriangles[fill[_destination[i]]++] = i / 3;
+            }
+        }
+
+        // interior edges are shared by two triangles, only consider them once
+        collapses.clear();
+        for (size_t i = 0; i < _destination.size(); i += 3) {
+            for (int j = 0; j < 3; ++j) {
+                GLuint a = _destination[i + j];
+                GLuint b = _destination[i + (j + 1) % 3];
+
+                if (a > b || (locked[a] && locked[b])) {
+                    continue;
+                }
+
+                Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+
+                float errorToB = locked[a] ? INFINITY : q.error(positions[b]);
+                float errorToA = locked[b] ? INFINITY : q.error(positions[a]);
+
+                if (errorToB <= errorToA) {
+                    collapses.push_back({ a, b, errorToB });
+                } else {
+                    collapses.push_back({ b, a, errorToA });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& _a, const Collapse& _b) {
+            return _a.error < _b.error;
+        });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+
+        size_t targetTriangles = _targetIndexCount / 3;
+        size_t removed = 0;
+        size_t nCollapses = 0;
+
+        for (const auto& collapse : collapses) {
+            if (collapse.error > targetError || nTriangles - removed <= targetTriangles) {
+                break;
+            }
+
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // reject the collapse when it flips a triangle around the removed vertex
+            bool flips = false;
+            size_t collapsed = 0;
+
+            for (GLuint t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !flips; ++t) {
+                const GLuint* triangle = &_destination[vertexTriangles[t] * 3];
+                GLuint corners[3] = { remap[triangle[0]], remap[triangle[1]], remap[triangle[2]] };
+
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to) {
+                    collapsed++;
+                    continue;
+                }
+
+                glm::vec3 p[3];
+                for (int j = 0; j < 3; ++j) {
+                    p[j] = positions[corners[j]];
+                }
+
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+                for (int j = 0; j < 3; ++j) {
+                    if (corners[j] == collapse.from) {
+                        p[j] = positions[collapse.to];
+                    }
+                }
+
+                glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+                flips = glm::dot(before, after) < 0.25f * glm::length(before) * glm::length(after);
+            }
+
+            if (flips) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            touched[collapse.from] = touched[collapse.to] = true;
+            maxError = std::max(maxError, double(collapse.error));
+            removed += collapsed;
+            nCollapses++;
+        }
+
+        if (nCollapses == 0) {
+            break;
+        }
+
+        // apply the collapses and drop the degenerate triangles
+        size_t size = 0;
+        for (size_t i = 0; i < _destination.size(); i += 3) {
+            GLuint a = remap[_destination[i + 0]];
+            GLuint b = remap[_destination[i + 1]];
+            GLuint c = remap[_destination[i + 2]];
+
+            if (a != b && b != c && c != a) {
+                _destination[size++] = a;
+                _destination[size++] = b;
+                _destination[size++] = c;
+            }
+        }
+        _destination.resize(size);
+    }
+
+    return std::sqrt(maxError);
+}
+
+} // OGLW
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "gl/glTypes.h"
+#include "core/types.h"
+
+namespace OGLW {
+
+// simplify an indexed triangle list by collapsing the edges with the smallest quadric error until at most
+// _targetIndexCount indices remain or no edge can be collapsed under _targetError, vertices are never moved
+// so that _destination indexes the same vertices, positions are 2 or 3 floats at _positionOffset.
+// the vertices on the borders of the mesh or on attribute seams are kept in place.
+// returns the error of the simplified mesh as a distance in the units of the positions
+float simplifyMesh(const std::vector<GLuint>& _indices, const GLbyte* _vertices, size_t _nVertices, size_t _stride,
+    size_t _positionOffset, uint _positionSize, size_t _targetIndexCount, float _targetError,
+    std::vector<GLuint>& _destination);
+
+} // OGLW
@@ -0,0 +1,422 @@
+#include "objParser.h"
+#include "core/mappedFile.h"
+#include "core/parallel.h"
+#include "core/log.h"
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+
+namespace OGLW {
+
+namespace {
+
+enum Attribute { position = 0, texcoord, normal };
+
+struct Corner {
+    int index[3];
+    // bit i is set when the attribute i is present, bit i + 3 when its index is relative to the chunk
+    uchar flags;
+};
+
+struct Group {
+    // first face of the group in its chunk
+    size_t face;
+    std::string name;
+    // materials split the current group and keep its name
+    bool keepName;
+};
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    std::vector<float> attributes[3];
+    std::vector<Corner> corners;
+    // first corner of each face in the chunk
+    std::vector<GLuint> faces;
+    std::vector<Group> groups;
+    // position of the chunk data in the whole file
+    size_t attributeOffsets[3];
+    size_t cornerOffset;
+    size_t faceOffset;
+};
+
+struct ShapeRange {
+    std::string name;
+    size_t firstFace;
+    size_t endFace;
+};
+
+struct CornerKey {
+    int index[3];
+
+    bool operator==(const CornerKey& _other) const {
+        return index[0] == _other.index[0] && index[1] == _other.index[1] && index[2] == _other.index[2];
+    }
+};
+
+struct CornerKeyHash {
+    size_t operator()(const CornerKey& _key) const {
+        uint64_t hash = uint32_t(_key.index[0]);
+        hash = hash * 0x9e3779b97f4a7c15ull ^ uint32_t(_key.index[1]);
+        hash = hash * 0x9e3779b97f4a7c15ull ^ uint32_t(_key.index[2]);
+        return size_t(hash ^ (hash >> 32));
+    }
+};
+
+const int attributeSizes[3] = { 3, 2, 3 };
+
+} // anonymous
+
+static inline bool isSpace(char _c) {
+    return _c == ' ' || _c == '\t' || _c == '\r';
+}
+
+static inline void skipSpaces(const char*& _p, const char* _end) {
+    while (_p < _end && isSpace(*_p)) {
+        ++_p;
+    }
+}
+
+static inline bool isDigit(char _c) {
+    return _c >= '0' && _c <= '9';
+}
+
+// parse a float with strtof so that the values round exactly as with the standard library, nan and inf
+// included, the token is copied as the chunk isn't null terminated, stops at the end of the number
+static float parseFloat(const char*& _p, const char* _end) {
+    skipSpaces(_p, _end);
+
+    char token[64];
+    size_t length = 0;
+
+    while (_p + length < _end && length < sizeof(token) - 1 && !isSpace(_p[length]) && _p[length] != '\n') {
+        token[length] = _p[length];
+        ++length;
+    }
+
+    token[length] = '\0';
+
+    char* end;
+    float value = std::strtof(token, &end);
+    _p += end - token;
+
+    return value;
+}
+
+static bool parseInt(const char*& _p, const char* _end, int& _value) {
+    bool negative = _p < _end && *_p == '-';
+    if (_p < _end && (*_p == '-' || *_p == '+')) {
+        ++_p;
+    }
+
+    if (_p >= _end || !isDigit(*_p)) {
+        return false;
+    }
+
+    _value = 0;
+    for (; _p < _end && isDigit(*_p); ++_p) {
+        _value = _value * 10 + (*_p - '0');
+    }
+
+    if (negative) {
+        _value = -_value;
+    }
+
+    return true;
+}
+
+static bool isKeyword(const char* _p, const char* _end, const char* _keyword) {
+    size_t length = std::strlen(_keyword);
+    return size_t(_end - _p) > length && std::strncmp(_p, _keyword, length) == 0 && isSpace(_p[length]);
+}
+
+static std::string parseName(const char* _p, const char* _end) {
+    skipSpaces(_p, _end);
+
+    while (_end > _p && isSpace(_end[-1])) {
+        --_end;
+    }
+
+    return std::string(_p, _end);
+}
+
+static void parseChunk(Chunk& _chunk) {
+    const char* line = _chunk.begin;
+
+    while (line < _chunk.end) {
+        const char* end = static_cast<const char*>(std::memchr(line, '\n', _chunk.end - line));
+        if (!end) {
+            end = _chunk.end;
+        }
+
+        const char* p = line;
+        line = end + 1;
+
+        skipSpaces(p, end);
+
+        if (p >= end || *p == '#') {
+            continue;
+        }
+
+        if (isKeyword(p, end, "v") || isKeyword(p, end, "vt") || isKeyword(p, end, "vn")) {
+            int attribute = p[1] == 't' ? texcoord : p[1] == 'n' ? normal : position;
+            auto& values = _chunk.attributes[attribute];
+
+            p += attribute == position ? 1 : 2;
+            for (int i = 0; i < attributeSizes[attribute]; ++i) {
+                values.push_back(parseFloat(p, end));
+            }
+        } else if (isKeyword(p, end, "f")) {
+            size_t first = _chunk.corners.size();
+
+            for (++p, skipSpaces(p, end); p < end; skipSpaces(p, end)) {
+                Corner corner = { { 0, 0, 0 }, 0 };
+
+                for (int i = 0; i < 3; ++i) {
+                    int value;
+
+                    if (parseInt(p, end, value) && value != 0) {
+                        // negative indices are relative to the attributes read so far
+                        if (value < 0) {
+                            int count = _chunk.attributes[i].size() / attributeSizes[i];
+                            corner.index[i] = count + value;
+                            corner.flags |= 1 << (i + 3);
+                        } else {
+                            corner.index[i] = value - 1;
+                        }
+                        corner.flags |= 1 << i;
+                    }
+
+                    if (p < end && *p == '/') {
+                        ++p;
+                    } else {
+                        break;
+                    }
+                }
+
+                // skip anything unexpected up to the next corner
+                while (p < end && !isSpace(*p)) {
+                    ++p;
+                }
+
+                if (corner.flags & 1) {
+                    _chunk.corners.push_back(corner);
+                }
+            }
+
+            if (_chunk.corners.size() - first >= 3) {
+                _chunk.faces.push_back(first);
+            } else {
+                _chunk.corners.resize(first);
+            }
+        } else if (isKeyword(p, end, "g") || isKeyword(p, end, "o")) {
+            _chunk.groups.push_back({ _chunk.faces.size(), parseName(p + 1, end), false });
+        } else if (isKeyword(p, end, "usemtl")) {
+            _chunk.groups.push_back({ _chunk.faces.size(), "", true });
+        }
+    }
+}
+
+static void buildShape(ObjShape& _shape, const ShapeRange& _range, const std::vector<float> (&_attributes)[3],
+    const std::vector<Corner>& _corners, const std::vector<GLuint>& _faces)
+{
+    bool hasAttribute[3] = { true, false, false };
+
+    for (size_t i = _faces[_range.firstFace]; i < _faces[_range.endFace]; ++i) {
+        hasAttribute[texcoord] |= (_corners[i].flags & (1 << texcoord)) != 0;
+        hasAttribute[normal] |= (_corners[i].flags & (1 << normal)) != 0;
+    }
+
+    std::vector<float>* destinations[3] = { &_shape.positions, &_shape.texcoords, &_shape.normals };
+    std::unordered_map<CornerKey, GLuint, CornerKeyHash> vertices;
+
+    _shape.name = _range.name;
+    _shape.indices.reserve((_faces[_range.endFace] - _faces[_range.firstFace]) * 3);
+    vertices.reserve(_faces[_range.endFace] - _faces[_range.firstFace]);
+
+    auto addCorner = [&](const Corner& _corner) {
+        CornerKey key;
+        for (int i = 0; i < 3; ++i) {
+            key.index[i] = (_corner.flags & (1 << i)) ? _corner.index[i] : -1;
+        }
+
+        auto inserted = vertices.emplace(key, GLuint(vertices.size()));
+
+        if (inserted.second) {
+            for (int i = 0; i < 3; ++i) {
+                if (!hasAttribute[i]) {
+                    continue;
+                }
+
+                // corners missing an attribute of the shape get zeros
+                for (int j = 0; j < attributeSizes[i]; ++j) {
+                    float value = key.index[i] >= 0 ? _attributes[i][key.index[i] * attributeSizes[i] + j] : 0.0f;
+                    destinations[i]->push_back(value);
+                }
+            }
+        }
+
+        _shape.indices.push_back(inserted.first->second);
+    };
+
+    for (size_t face = _range.firstFace; face < _range.endFace; ++face) {
+        GLuint first = _faces[face];
+        GLuint end = _faces[face + 1];
+
+        for (GLuint corner = first + 2; corner < end; ++corner) {
+            addCorner(_corners[first]);
+            addCorner(_corners[corner - 1]);
+            addCorner(_corners[corner]);
+        }
+    }
+}
+
+bool parseOBJ(const std::string& _path, std::vector<ObjShape>& _shapes, uint _threads) {
+    MappedFile file(_path);
+
+    if (!file.isValid()) {
+        WARN("Can't read OBJ file %s\n", _path.c_str());
+        return false;
+    }
+
+    const char* data = reinterpret_cast<const char*>(file.getData());
+    const char* dataEnd = data + file.getSize();
+
+    // small files aren't worth splitting
+    const size_t minChunkSize = 1 << 20;
+    size_t nChunks = std::max<size_t>(1, std::min<size_t>(_threads > 0 ? _threads : hardwareThreads(),
+        file.getSize() / minChunkSize));
+    std::vector<Chunk> chunks(nChunks);
+
+    // split the file on line boundaries
+    const char* begin = data;
+    for (size_t i = 0; i < nChunks; ++i) {
+        const char* end = i + 1 == nChunks ? dataEnd : data + file.getSize() * (i + 1) / nChunks;
+
+        if (end < begin) {
+            end = begin;
+        }
+
+        const char* newline = static_cast<const char*>(std::memchr(end, '\n', dataEnd - end));
+        end = newline ? newline + 1 : dataEnd;
+
+        chunks[i].begin = begin;
+        chunks[i].end = i + 1 == nChunks ? dataEnd : end;
+        begin = chunks[i].end;
+    }
+
+    parallelFor(0, nChunks, 1, [&](size_t _begin, size_t _end) {
+        for (size_t i = _begin; i < _end; ++i) {
+            parseChunk(chunks[i]);
+        }
+    });
+
+    size_t attributeCounts[3] = { 0, 0, 0 };
+    size_t nCorners = 0;
+    size_t nFaces = 0;
+
+    for (auto& chunk : chunks) {
+        for (int i = 0; i < 3; ++i) {
+            chunk.attributeOffsets[i] = attributeCounts[i];
+            attributeCounts[i] += chunk.attributes[i].size() / attributeSizes[i];
+        }
+
+        chunk.cornerOffset = nCorners;
+        chunk.faceOffset = nFaces;
+        nCorners += chunk.corners.size();
+        nFaces += chunk.faces.size();
+    }
+
+    std::vector<float> attributes[3];
+    std::vector<Corner> corners(nCorners);
+    std::vector<GLuint> faces(nFaces + 1);
+    std::atomic<bool> validPositions(true);
+    std::atomic<bool> validAttributes(true);
+
+    for (int i = 0; i < 3; ++i) {
+        attributes[i].resize(attributeCounts[i] * attributeSizes[i]);
+    }
+
+    faces[nFaces] = nCorners;
+
+    // merge the chunks, fixing up the relative indices and the face offsets
+    parallelFor(0, nChunks, 1, [&](size_t _begin, size_t _end) {
+        for (size_t c = _begin; c < _end; ++c) {
+            Chunk& chunk = chunks[c];
+
+            for (int i = 0; i < 3; ++i) {
+                std::copy(chunk.attributes[i].begin(), chunk.attributes[i].end(),
+                    attributes[i].begin() + chunk.attributeOffsets[i] * attributeSizes[i]);
+                std::vector<float>().swap(chunk.attributes[i]);
+            }
+
+            for (size_t j = 0; j < chunk.corners.size(); ++j) {
+                Corner corner = chunk.corners[j];
+
+                for (int i = 0; i < 3; ++i) {
+                    if (corner.flags & (1 << (i + 3))) {
+                        corner.index[i] += chunk.attributeOffsets[i];
+                    }
+
+                    bool present = corner.flags & (1 << i);
+
+                    if (present && (corner.index[i] < 0 || size_t(corner.index[i]) >= attributeCounts[i])) {
+                        (i == position ? validPositions : validAttributes) = false;
+                        corner.flags &= ~(1 << i);
+                    }
+                }
+
+                corners[chunk.cornerOffset + j] = corner;
+            }
+
+            for (size_t j = 0; j < chunk.faces.size(); ++j) {
+                faces[chunk.faceOffset + j] = chunk.faces[j] + chunk.cornerOffset;
+            }
+        }
+    });
+
+    if (!validPositions) {
+        WARN("OBJ file %s references positions out of range\n", _path.c_str());
+        return false;
+    }
+
+    if (!validAttributes) {
+        WARN("OBJ file %s references normals or texture coordinates out of range, ignoring them\n",
+            _path.c_str());
+    }
+
+    // the groups of a chunk continue the last group of the previous chunk
+    std::vector<ShapeRange> ranges;
+    ShapeRange current = { "", 0, 0 };
+
+    for (const auto& chunk : chunks) {
+        for (const auto& group : chunk.groups) {
+            current.endFace = chunk.faceOffset + group.face;
+            ranges.push_back(current);
+            current = { group.keepName ? current.name : group.name, current.endFace, current.endFace };
+        }
+    }
+
+    current.endFace = nFaces;
+    ranges.push_back(current);
+
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [](const ShapeRange& _range) {
+        return _range.firstFace == _range.endFace;
+    }), ranges.end());
+
+    _shapes.clear();
+    _shapes.resize(ranges.size());
+
+    parallelFor(0, ranges.size(), 1, [&](size_t _begin, size_t _end) {
+        for (size_t i = _begin; i < _end; ++i) {
+            buildShape(_shapes[i], ranges[i], attributes, corners, faces);
+        }
+    });
+
+    return true;
+}
+
+} // OGLW
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "gl/glTypes.h"
+#include "core/types.h"
+
+namespace OGLW {
+
+// A group of faces of an OBJ file, split on groups, objects and materials. Each distinct
+// position, texture coordinate and normal index triplet becomes a vertex in the order it is
+// first referenced, polygons are triangulated as fans.
+struct ObjShape {
+    std::string name;
+    // 3 floats per vertex
+    std::vector<float> positions;
+    // 3 floats per vertex, empty if the faces don't reference normals
+    std::vector<float> normals;
+    // 2 floats per vertex, empty if the faces don't reference texture coordinates
+    std::vector<float> texcoords;
+    std::vector<GLuint> indices;
+};
+
+// parse the geometry of an OBJ file, the file is split in line aligned chunks parsed concurrently
+// on _threads threads, 0 uses all the hardware threads
+bool parseOBJ(const std::string& _path, std::vector<ObjShape>& _shapes, uint _threads = 0);
+
+} // OGLW
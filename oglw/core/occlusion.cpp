@@ -0,0 +1,324 @@
+#include "occlusion.h"
+#include "core/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace OGLW {
+
+// rows of the depth buffer rasterized together by a thread
+static const uint occlusionBandHeight = 16;
+// smallest range of boxes tested by a thread
+static const size_t occlusionGrainSize = 1024;
+
+OcclusionCuller::OcclusionCuller(uint _width, uint _height) :
+    m_width(std::max(_width, 1u)),
+    m_height(std::max(_height, 1u)),
+    m_viewProjection(1.0f),
+    m_rasterized(false)
+{
+    // rows are padded to a multiple of 4 pixels, the padding is never read back as screen pixels
+    uint width = (m_width + 3) & ~3u;
+    uint height = m_height;
+
+    while (true) {
+        m_levels.push_back({ width, height, std::vector<float>(width * height, 1.0f) });
+
+        if (width == 1 && height == 1) {
+            break;
+        }
+
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    m_bins.resize((m_height + occlusionBandHeight - 1) / occlusionBandHeight);
+}
+
+void OcclusionCuller::begin(const glm::mat4& _viewProjection) {
+    m_viewProjection = _viewProjection;
+    m_triangles.clear();
+    m_rasterized = false;
+}
+
+void OcclusionCuller::addOccluder(const void* _positions, size_t _count, size_t _stride, const uint* _indices,
+    size_t _nIndices, const glm::mat4& _model)
+{
+    glm::mat4 transform = m_viewProjection * _model;
+    std::vector<glm::vec4> clip(_count);
+    const char* data = static_cast<const char*>(_positions);
+
+    for (size_t i = 0; i < _count; ++i) {
+        const float* position = reinterpret_cast<const float*>(data + i * _stride);
+        clip[i] = transform * glm::vec4(position[0], position[1], position[2], 1.0f);
+    }
+
+    for (size_t i = 0; i + 2 < _nIndices; i += 3) {
+        Triangle triangle;
+        bool clipped = false;
+
+        for (int v = 0; v < 3 && !clipped; ++v) {
+            const glm::vec4& p = clip[_indices[i + v]];
+
+            // an occluder only needs to be conservative, the triangles crossing the near plane
+            // are dropped instead of being clipped
+            if (p.z < -p.w || p.w <= 0.0f) {
+                clipped = true;
+                break;
+            }
+
+            triangle.v[v] = glm::vec3((p.x / p.w * 0.5f + 0.5f) * m_width, (p.y / p.w * 0.5f + 0.5f) * m_height,
+                p.z / p.w * 0.5f + 0.5f);
+        }
+
+        if (clipped) {
+            continue;
+        }
+
+        float minX = std::min(triangle.v[0].x, std::min(triangle.v[1].x, triangle.v[2].x));
+        float maxX = std::max(triangle.v[0].x, std::max(triangle.v[1].x, triangle.v[2].x));
+        triangle.minY = std::min(triangle.v[0].y, std::min(triangle.v[1].y, triangle.v[2].y));
+        triangle.maxY = std::max(triangle.v[0].y, std::max(triangle.v[1].y, triangle.v[2].y));
+
+        if (maxX < 0.0f || minX > m_width || triangle.maxY < 0.0f || triangle.minY > m_height) {
+            continue;
+        }
+
+        m_triangles.push_back(triangle);
+    }
+}
+
+void OcclusionCuller::rasterize(uint _threads) {
+    for (auto& bin : m_bins) {
+        bin.clear();
+    }
+
+    for (uint t = 0; t < m_triangles.size(); ++t) {
+        const Triangle& triangle = m_triangles[t];
+        int first = std::max(0, int(triangle.minY) / int(occlusionBandHeight));
+        int last = std::min(int(m_bins.size()) - 1, int(triangle.maxY) / int(occlusionBandHeight));
+
+        for (int band = first; band <= last; ++band) {
+            m_bins[band].push_back(t);
+        }
+    }
+
+    size_t nRanges = std::min<size_t>(_threads > 0 ? _threads : hardwareThreads(), m_bins.size());
+    size_t rangeSize = (m_bins.size() + nRanges - 1) / nRanges;
+
+    parallelFor(0, nRanges, 1, [&](size_t _begin, size_t _end) {
+        for (size_t range = _begin; range < _end; ++range) {
+            size_t last = std::min(range * rangeSize + rangeSize, m_bins.size());
+
+            for (size_t band = range * rangeSize; band < last; ++band) {
+                rasterizeBand(band);
+            }
+        }
+    });
+
+    buildPyramid();
+    m_rasterized = true;
+}
+
+void OcclusionCuller::rasterizeBand(uint _band) {
+    Level& level = m_levels[0];
+    int firstRow = _band * occlusionBandHeight;
+    int lastRow = std::min(firstRow + int(occlusionBandHeight), int(m_height)) - 1;
+
+    std::fill(level.depth.begin() + firstRow * level.width, level.depth.begin() + (lastRow + 1) * level.width, 1.0f);
+
+    for (uint t : m_bins[_band]) {
+        glm::vec3 v0 = m_triangles[t].v[0];
+        glm::vec3 v1 = m_triangles[t].v[1];
+        glm::vec3 v2 = m_triangles[t].v[2];
+
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+
+        if (area == 0.0f) {
+            continue;
+        }
+
+        // occluders are rasterized double sided, the edge functions are positive inside
+        if (area < 0.0f) {
+            std::swap(v1, v2);
+            area = -area;
+        }
+
+        // edge functions a * x + b * y + c of the edges v0v1, v1v2 and v2v0
+        float a[3] = { v0.y - v1.y, v1.y - v2.y, v2.y - v0.y };
+        float b[3] = { v1.x - v0.x, v2.x - v1.x, v0.x - v2.x };
+        float c[3] = {
+            -(a[0] * v0.x + b[0] * v0.y),
+            -(a[1] * v1.x + b[1] * v1.y),
+            -(a[2] * v2.x + b[2] * v2.y)
+        };
+
+        // depth plane, screen space depth is linear in x and y
+        float dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        float dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        float z0 = v0.z - dzdx * v0.x - dzdy * v0.y;
+
+        int minX = std::max(0, int(std::floor(std::min(v0.x, std::min(v1.x, v2.x))))) & ~3;
+        int maxX = std::min(int(level.width) - 1, int(std::max(v0.x, std::max(v1.x, v2.x))));
+        int minY = std::max(firstRow, int(std::floor(std::min(v0.y, std::min(v1.y, v2.y)))));
+        int maxY = std::min(lastRow, int(std::max(v0.y, std::max(v1.y, v2.y))));
+
+        for (int y = minY; y <= maxY; ++y) {
+            float* row = level.depth.data() + y * level.width;
+            float py = y + 0.5f;
+            int x = minX;
+
+#if defined(__SSE__)
+            __m128 edgeRow[3], edgeStep[3];
+            for (int e = 0; e < 3; ++e) {
+                edgeRow[e] = _mm_set1_ps(b[e] * py + c[e]);
+                edgeStep[e] = _mm_set1_ps(a[e]);
+            }
+
+            __m128 zRow = _mm_set1_ps(z0 + dzdy * py);
+            __m128 zStep = _mm_set1_ps(dzdx);
+            __m128 zero = _mm_setzero_ps();
+
+            // rows are padded to a multiple of 4 pixels, the last group never writes out of the row
+            for (; x <= maxX; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStep[0], px), edgeRow[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStep[1], px), edgeRow[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStep[2], px), edgeRow[2]), zero));
+
+                if (!_mm_movemask_ps(inside)) {
+                    continue;
+                }
+
+                __m128 depth = _mm_loadu_ps(row + x);
+                __m128 z = _mm_min_ps(depth, _mm_add_ps(_mm_mul_ps(zStep, px), zRow));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, z), _mm_andnot_ps(inside, depth)));
+            }
+#else
+            for (; x <= maxX; ++x) {
+                float px = x + 0.5f;
+
+                if (a[0] * px + b[0] * py + c[0] >= 0.0f && a[1] * px + b[1] * py + c[1] >= 0.0f
+                    && a[2] * px + b[2] * py + c[2] >= 0.0f) {
+                    row[x] = std::min(row[x], z0 + dzdx * px + dzdy * py);
+                }
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid() {
+    for (size_t l = 1; l < m_levels.size(); ++l) {
+        const Level& source = m_levels[l - 1];
+        Level& level = m_levels[l];
+
+        for (uint y = 0; y < level.height; ++y) {
+            const float* row0 = source.depth.data() + std::min(2 * y, source.height - 1) * source.width;
+            const float* row1 = source.depth.data() + std::min(2 * y + 1, source.height - 1) * source.width;
+
+            for (uint x = 0; x < level.width; ++x) {
+                uint x0 = std::min(2 * x, source.width - 1);
+                uint x1 = std::min(2 * x + 1, source.width - 1);
+
+                level.depth[y * level.width + x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const glm::vec3& _min, const glm::vec3& _max) const {
+    if (!m_rasterized || m_triangles.empty()) {
+        return true;
+    }
+
+    glm::vec3 screenMin(std::numeric_limits<float>::max());
+    glm::vec3 screenMax(-std::numeric_limits<float>::max());
+
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 p = m_viewProjection * glm::vec4(corner & 1 ? _max.x : _min.x, corner & 2 ? _max.y : _min.y,
+            corner & 4 ? _max.z : _min.z, 1.0f);
+
+        // a box crossing the near plane covers the camera, it can't be tested
+        if (p.z < -p.w || p.w <= 0.0f) {
+            return true;
+        }
+
+        glm::vec3 screen((p.x / p.w * 0.5f + 0.5f) * m_width, (p.y / p.w * 0.5f + 0.5f) * m_height,
+            p.z / p.w * 0.5f + 0.5f);
+
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+    }
+
+    if (screenMax.x < 0.0f || screenMin.x > m_width || screenMax.y < 0.0f || screenMin.y > m_height) {
+        return false;
+    }
+
+    int x0 = std::max(0, int(std::floor(screenMin.x)));
+    int y0 = std::max(0, int(std::floor(screenMin.y)));
+    int x1 = std::min(int(m_width) - 1, int(screenMax.x));
+    int y1 = std::min(int(m_height) - 1, int(screenMax.y));
+
+    // the finest level where the rectangle covers at most 2x2 texels
+    size_t l = 0;
+    while (l + 1 < m_levels.size() && ((x1 >> l) - (x0 >> l) > 1 || (y1 >> l) - (y0 >> l) > 1)) {
+        ++l;
+    }
+
+    const Level& level = m_levels[l];
+
+    for (int y = y0 >> l; y <= y1 >> l; ++y) {
+        for (int x = x0 >> l; x <= x1 >> l; ++x) {
+            if (screenMin.z <= level.depth[y * level.width + x]) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void OcclusionCuller::cull(const AABBArray& _boxes, std::vector<uint>& _visible, uint _threads) const {
+    if (!m_rasterized || m_triangles.empty()) {
+        return;
+    }
+
+    auto cullRange = [&](size_t _begin, size_t _end, std::vector<uint>& _out) {
+        for (size_t i = _begin; i < _end; ++i) {
+            uint index = _visible[i];
+            glm::vec3 min(_boxes.minX[index], _boxes.minY[index], _boxes.minZ[index]);
+            glm::vec3 max(_boxes.maxX[index], _boxes.maxY[index], _boxes.maxZ[index]);
+
+            if (isVisible(min, max)) {
+                _out.push_back(index);
+            }
+        }
+    };
+
+    size_t count = _visible.size();
+    size_t nRanges = std::max<size_t>(1, std::min<size_t>(_threads > 0 ? _threads : hardwareThreads(),
+        (count + occlusionGrainSize - 1) / occlusionGrainSize));
+
+    size_t rangeSize = (count + nRanges - 1) / nRanges;
+    std::vector<std::vector<uint>> rangeVisible(nRanges);
+
+    parallelFor(0, nRanges, 1, [&](size_t _begin, size_t _end) {
+        for (size_t range = _begin; range < _end; ++range) {
+            size_t start = range * rangeSize;
+            rangeVisible[range].reserve(rangeSize);
+            cullRange(start, std::min(start + rangeSize, count), rangeVisible[range]);
+        }
+    });
+
+    _visible.clear();
+
+    for (const auto& visible : rangeVisible) {
+        _visible.insert(_visible.end(), visible.begin(), visible.end());
+    }
+}
+
+} // OGLW
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "glm/glm.hpp"
+#include "core/types.h"
+#include "core/culling.h"
+
+namespace OGLW {
+
+// Software occlusion culling. Occluder triangles are rasterized in a low resolution depth buffer
+// by worker threads, each one filling bands of rows 4 pixels at a time with SSE. A pyramid keeping
+// the farthest depth of each 2x2 block is then built, and an occludee box is hidden when its
+// nearest depth is behind all the pyramid texels covering its screen rectangle, read at the level
+// where the rectangle spans at most 2x2 texels. No GPU readback is involved, occluders are meant
+// to be a few large low polygon meshes (terrain hulls, walls, buildings).
+class OcclusionCuller {
+public:
+    // _width and _height are the resolution of the depth buffer
+    OcclusionCuller(uint _width = 320, uint _height = 192);
+
+    // clear the occluders for a new frame seen through _viewProjection, a projection with the
+    // depth increasing with the distance, not a reverse Z one
+    void begin(const glm::mat4& _viewProjection);
+    // add the triangles _indices of _count positions of 3 floats stored _stride bytes apart,
+    // transformed by _model, the triangles crossing the near plane are skipped
+    void addOccluder(const void* _positions, size_t _count, size_t _stride, const uint* _indices,
+        size_t _nIndices, const glm::mat4& _model = glm::mat4(1.0f));
+    // rasterize the occluders and build the depth pyramid, _threads 0 uses all the hardware threads
+    void rasterize(uint _threads = 0);
+
+    // whether a world space box may be visible behind the occluders
+    bool isVisible(const glm::vec3& _min, const glm::vec3& _max) const;
+    // remove the indices of the occluded boxes from _visible, typically the output of cullAABBs,
+    // _threads 0 uses all the hardware threads
+    void cull(const AABBArray& _boxes, std::vector<uint>& _visible, uint _threads = 0) const;
+
+    uint getWidth() const { return m_width; }
+    uint getHeight() const { return m_height; }
+    // number of occluder triangles added this frame
+    size_t getTriangleCount() const { return m_triangles.size(); }
+    // the rasterized depth in [0, 1], getStride() floats per row
+    const std::vector<float>& getDepth() const { return m_levels[0].depth; }
+    uint getStride() const { return m_levels[0].width; }
+
+private:
+    // a triangle in screen space, x and y in pixels and z the depth in [0, 1]
+    struct Triangle {
+        glm::vec3 v[3];
+        float minY;
+        float maxY;
+    };
+
+    struct Level {
+        uint width;
+        uint height;
+        std::vector<float> depth;
+    };
+
+    // rasterize the binned triangles of a band of rows
+    void rasterizeBand(uint _band);
+    // build the max depth levels from the rasterized depth
+    void buildPyramid();
+
+    uint m_width;
+    uint m_height;
+    glm::mat4 m_viewProjection;
+    std::vector<Triangle> m_triangles;
+    // triangles overlapping each band of rows
+    std::vector<std::vector<uint>> m_bins;
+    // the rasterized depth followed by its max depth pyramid
+    std::vector<Level> m_levels;
+    bool m_rasterized;
+};
+
+} // OGLW
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <thread>
+#include <algorithm>
+#include "core/types.h"
+#include "core/jobSystem.h"
+
+namespace OGLW {
+
+// number of threads to use for parallel work, at least one
+static inline uint hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// split [_begin, _end) in contiguous ranges of at least _grain elements and call _fn(begin, end)
+// on each of them concurrently on the shared job system, the calling thread processes the first
+// range and returns once all of them are done
+template <typename Fn>
+void parallelFor(size_t _begin, size_t _end, size_t _grain, Fn _fn) {
+    JobSystem::get().parallelFor(_begin, _end, _grain, _fn);
+}
+
+} // OGLW
@@ -0,0 +1,106 @@
+#include "rangeAllocator.h"
+#include "core/log.h"
+
+namespace OGLW {
+
+RangeAllocator::RangeAllocator(size_t _size) {
+    reset(_size);
+}
+
+void RangeAllocator::reset(size_t _size) {
+    m_blocksByOffset.clear();
+    m_blocksBySize.clear();
+    m_size = _size;
+    m_freeSize = 0;
+
+    if (_size > 0) {
+        addBlock(0, _size);
+    }
+}
+
+void RangeAllocator::addBlock(size_t _offset, size_t _size) {
+    m_blocksByOffset[_offset] = _size;
+    m_blocksBySize.insert({ _size, _offset });
+    m_freeSize += _size;
+}
+
+void RangeAllocator::removeBlock(std::map<size_t, size_t>::iterator _block) {
+    m_blocksBySize.erase({ _block->second, _block->first });
+    m_freeSize -= _block->second;
+    m_blocksByOffset.erase(_block);
+}
+
+bool RangeAllocator::allocate(size_t _size, size_t& _offset) {
+    if (_size == 0) {
+        _offset = 0;
+        return true;
+    }
+
+    auto fit = m_blocksBySize.lower_bound({ _size, 0 });
+
+    if (fit == m_blocksBySize.end()) {
+        return false;
+    }
+
+    size_t blockSize = fit->first;
+    size_t blockOffset = fit->second;
+
+    removeBlock(m_blocksByOffset.find(blockOffset));
+
+    if (blockSize > _size) {
+        addBlock(blockOffset + _size, blockSize - _size);
+    }
+
+    _offset = blockOffset;
+
+    return true;
+}
+
+void RangeAllocator::release(size_t _offset, size_t _size) {
+    if (_size == 0) {
+        return;
+    }
+
+    if (_offset + _size > m_size) {
+        WARN("Releasing range [%d, %d) out of the allocator space\n", (int)_offset, (int)(_offset + _size));
+        return;
+    }
+
+    // merge with the free blocks right after and right before the range
+    auto next = m_blocksByOffset.lower_bound(_offset);
+
+    if (next != m_blocksByOffset.end() && next->first == _offset + _size) {
+        _size += next->second;
+        removeBlock(next);
+        next = m_blocksByOffset.lower_bound(_offset);
+    }
+
+    if (next != m_blocksByOffset.begin()) {
+        auto previous = std::prev(next);
+
+        if (previous->first + previous->second == _offset) {
+            _offset = previous->first;
+            _size += previous->second;
+            removeBlock(previous);
+        }
+    }
+
+    addBlock(_offset, _size);
+}
+
+void RangeAllocator::grow(size_t _size) {
+    if (_size <= m_size) {
+        return;
+    }
+
+    size_t offset = m_size;
+    m_size = _size;
+
+    release(offset, _size - offset);
+}
+
+size_t RangeAllocator::getLargestFreeBlock() const {
+    return m_blocksBySize.empty() ? 0 : m_blocksBySize.rbegin()->first;
+}
+
+} // OGLW
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <utility>
+#include <cstddef>
+
+namespace OGLW {
+
+// Best fit allocator of ranges in a linear space of units, such as vertices of a buffer.
+// Free blocks are indexed by offset to coalesce neighbours on release, and by size to find
+// the smallest block an allocation fits in, both in logarithmic time.
+class RangeAllocator {
+public:
+    RangeAllocator(size_t _size = 0);
+
+    // allocate _size units, false if no free block is large enough
+    bool allocate(size_t _size, size_t& _offset);
+    // release a range previously allocated
+    void release(size_t _offset, size_t _size);
+    // extend the space to _size units, the new units are free
+    void grow(size_t _size);
+    // release all the ranges
+    void reset(size_t _size);
+
+    // total number of units
+    size_t getSize() const { return m_size; }
+    // number of free units
+    size_t getFreeSize() const { return m_freeSize; }
+    // size of the largest free block
+    size_t getLargestFreeBlock() const;
+    // number of free blocks, more than one means the space is fragmented
+    size_t getFreeBlockCount() const { return m_blocksByOffset.size(); }
+
+private:
+    void addBlock(size_t _offset, size_t _size);
+    void removeBlock(std::map<size_t, size_t>::iterator _block);
+
+    // offset to size of the free blocks
+    std::map<size_t, size_t> m_blocksByOffset;
+    // size and offset of the free blocks
+    std::set<std::pair<size_t, size_t>> m_blocksBySize;
+    size_t m_size;
+    size_t m_freeSize;
+};
+
+} // OGLW
@@ -0,0 +1,314 @@
+#include "transformHierarchy.h"
+#include "core/parallel.h"
+#include "core/log.h"
+#include <algorithm>
+
+namespace OGLW {
+
+// smallest range of transforms of a level updated by a thread
+static const size_t transformGrainSize = 512;
+
+const TransformHierarchy::Handle TransformHierarchy::invalidHandle;
+const uint TransformHierarchy::invalidSlot;
+
+TransformHierarchy::TransformHierarchy() :
+    m_hierarchyDirty(false)
+{}
+
+bool TransformHierarchy::isValid(Handle _transform) const {
+    uint index = indexOf(_transform);
+
+    return index < m_slots.size() && m_generations[index] == generationOf(_transform)
+        && m_slots[index] != invalidSlot && !m_destroyed[m_slots[index]];
+}
+
+TransformHierarchy::Handle TransformHierarchy::create(Handle _parent) {
+    if (_parent != invalidHandle && !isValid(_parent)) {
+        WARN("Creating a transform with an invalid parent\n");
+        _parent = invalidHandle;
+    }
+
+    uint index;
+
+    if (m_freeIndices.empty()) {
+        index = m_slots.size();
+        m_slots.push_back(invalidSlot);
+        m_generations.push_back(0);
+    } else {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+
+    Handle handle = Handle(m_generations[index]) << 32 | index;
+
+    // new transforms are appended, they are moved to their depth level on the next update
+    m_slots[index] = m_handleOfSlot.size();
+
+    m_positions.emplace_back(0.0f);
+    m_rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+    m_scales.emplace_back(1.0f);
+    m_worlds.emplace_back(1.0f);
+    m_parents.push_back(invalidSlot);
+    m_firstChildren.push_back(0);
+    m_childCounts.push_back(0);
+    m_parentHandles.push_back(_parent);
+    m_handleOfSlot.push_back(handle);
+    m_destroyed.push_back(0);
+    m_localDirty.push_back(0);
+    m_changed.push_back(0);
+
+    touch(m_slots[index]);
+    m_hierarchyDirty = true;
+
+    return handle;
+}
+
+void TransformHierarchy::destroy(Handle _transform) {
+    if (!isValid(_transform)) {
+        WARN("Destroying an invalid transform\n");
+        return;
+    }
+
+    // the slot and the handle are released when sorting, the descendants still refer to them
+    m_destroyed[slotOf(_transform)] = 1;
+    m_hierarchyDirty = true;
+}
+
+void TransformHierarchy::setParent(Handle _transform, Handle _parent) {
+    if (!isValid(_transform) || (_parent != invalidHandle && !isValid(_parent))) {
+        WARN("Setting the parent of an invalid transform\n");
+        return;
+    }
+
+    for (Handle ancestor = _parent; ancestor != invalidHandle; ancestor = getParent(ancestor)) {
+        if (ancestor == _transform) {
+            WARN("A transform can't be attached to one of its descendants\n");
+            return;
+        }
+    }
+
+    m_parentHandles[slotOf(_transform)] = _parent;
+    touch(slotOf(_transform));
+    m_hierarchyDirty = true;
+}
+
+void TransformHierarchy::touch(uint _slot) {
+    if (!m_localDirty[_slot]) {
+        m_localDirty[_slot] = 1;
+        m_dirtySlots.push_back(_slot);
+    }
+}
+
+void TransformHierarchy::setPosition(Handle _transform, const glm::vec3& _position) {
+    uint slot = slotOf(_transform);
+    m_positions[slot] = _position;
+    touch(slot);
+}
+
+void TransformHierarchy::setRotation(Handle _transform, const glm::quat& _rotation) {
+    uint slot = slotOf(_transform);
+    m_rotations[slot] = _rotation;
+    touch(slot);
+}
+
+void TransformHierarchy::setScale(Handle _transform, const glm::vec3& _scale) {
+    uint slot = slotOf(_transform);
+    m_scales[slot] = _scale;
+    touch(slot);
+}
+
+void TransformHierarchy::sortByDepth() {
+    uint count = m_handleOfSlot.size();
+
+    // children of each slot, grouped by parent
+    std::vector<uint> childStarts(count + 1, 0);
+    for (uint slot = 0; slot < count; ++slot) {
+        Handle parent = m_parentHandles[slot];
+        if (parent != invalidHandle) {
+            childStarts[slotOf(parent) + 1]++;
+        }
+    }
+    for (uint slot = 0; slot < count; ++slot) {
+        childStarts[slot + 1] += childStarts[slot];
+    }
+
+    std::vector<uint> children(childStarts.back());
+    std::vector<uint> next(childStarts.begin(), childStarts.end() - 1);
+
+    for (uint slot = 0; slot < count; ++slot) {
+        Handle parent = m_parentHandles[slot];
+        if (parent != invalidHandle) {
+            children[next[slotOf(parent)]++] = slot;
+        }
+    }
+
+    // breadth first walk from the roots, the children of a transform are appended together, and the
+    // destroyed transforms are never visited, nor are their descendants
+    std::vector<uint> order;
+    order.reserve(count);
+
+    for (uint slot = 0; slot < count; ++slot) {
+        if (m_parentHandles[slot] == invalidHandle && !m_destroyed[slot]) {
+            order.push_back(slot);
+        }
+    }
+
+    std::vector<uint> firstChildren;
+    std::vector<uint> childCounts;
+    firstChildren.reserve(count);
+    childCounts.reserve(count);
+
+    m_levels.assign(1, 0);
+
+    for (size_t levelBegin = 0; levelBegin < order.size(); levelBegin = m_levels.back()) {
+        size_t levelEnd = order.size();
+        m_levels.push_back(levelEnd);
+
+        for (size_t i = levelBegin; i < levelEnd; ++i) {
+            uint slot = order[i];
+            size_t first = order.size();
+
+            for (uint c = childStarts[slot]; c < childStarts[slot + 1]; ++c) {
+                if (!m_destroyed[children[c]]) {
+                    order.push_back(children[c]);
+                }
+            }
+
+            firstChildren.push_back(first);
+            childCounts.push_back(order.size() - first);
+        }
+    }
+
+    // release the handles of the destroyed transforms and of their descendants
+    std::vector<uint8_t> visited(count, 0);
+    for (uint slot : order) {
+        visited[slot] = 1;
+    }
+
+    for (uint slot = 0; slot < count; ++slot) {
+        if (!visited[slot]) {
+            uint index = indexOf(m_handleOfSlot[slot]);
+            m_slots[index] = invalidSlot;
+            m_generations[index]++;
+            m_freeIndices.push_back(index);
+        }
+    }
+
+    auto permute = [&](auto& _array) {
+        typename std::decay<decltype(_array)>::type sorted(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            sorted[i] = _array[order[i]];
+        }
+        _array.swap(sorted);
+    };
+
+    permute(m_positions);
+    permute(m_rotations);
+    permute(m_scales);
+    permute(m_worlds);
+    permute(m_parentHandles);
+    permute(m_handleOfSlot);
+    permute(m_localDirty);
+    permute(m_changed);
+
+    m_destroyed.assign(order.size(), 0);
+    m_firstChildren.swap(firstChildren);
+    m_childCounts.swap(childCounts);
+
+    for (uint slot = 0; slot < order.size(); ++slot) {
+        m_slots[indexOf(m_handleOfSlot[slot])] = slot;
+    }
+
+    m_parents.resize(order.size());
+    for (uint slot = 0; slot < order.size(); ++slot) {
+        Handle parent = m_parentHandles[slot];
+        m_parents[slot] = parent == invalidHandle ? invalidSlot : slotOf(parent);
+    }
+
+    // the dirty slots moved
+    m_dirtySlots.clear();
+    for (uint slot = 0; slot < order.size(); ++slot) {
+        if (m_localDirty[slot]) {
+            m_dirtySlots.push_back(slot);
+        }
+    }
+
+    m_hierarchyDirty = false;
+}
+
+void TransformHierarchy::update() {
+    // the changed flags of the last update are cleared before the slots move
+    for (uint slot : m_changedSlots) {
+        m_changed[slot] = 0;
+    }
+    m_changedSlots.clear();
+
+    if (m_hierarchyDirty) {
+        sortByDepth();
+    }
+
+    if (m_dirtySlots.empty()) {
+        return;
+    }
+
+    // the slots are sorted by level, so are the dirty slots once sorted
+    std::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+
+    size_t dirty = 0;
+    size_t levelBegin = 0;
+
+    // the levels are updated in order, the transforms of a level only read the world matrices of the
+    // previous one, the transforms to update on a level are the children of the ones changed on the
+    // previous level, which were appended to m_changedSlots, and the dirty ones of the level
+    for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+        for (; dirty < m_dirtySlots.size() && m_dirtySlots[dirty] < m_levels[level + 1]; ++dirty) {
+            uint slot = m_dirtySlots[dirty];
+            uint parent = m_parents[slot];
+
+            if (parent == invalidSlot || !m_changed[parent]) {
+                m_changedSlots.push_back(slot);
+            }
+        }
+
+        size_t levelEnd = m_changedSlots.size();
+
+        if (levelBegin == levelEnd) {
+            if (dirty == m_dirtySlots.size()) {
+                break;
+            }
+            continue;
+        }
+
+        parallelFor(levelBegin, levelEnd, transformGrainSize, [&](size_t _begin, size_t _end) {
+            for (size_t i = _begin; i < _end; ++i) {
+                uint slot = m_changedSlots[i];
+                uint parent = m_parents[slot];
+
+                m_changed[slot] = 1;
+                m_localDirty[slot] = 0;
+
+                glm::mat4 local = glm::mat4_cast(m_rotations[slot]);
+                local[0] *= m_scales[slot].x;
+                local[1] *= m_scales[slot].y;
+                local[2] *= m_scales[slot].z;
+                local[3] = glm::vec4(m_positions[slot], 1.0f);
+
+                m_worlds[slot] = parent == invalidSlot ? local : m_worlds[parent] * local;
+            }
+        });
+
+        for (size_t i = levelBegin; i < levelEnd; ++i) {
+            uint slot = m_changedSlots[i];
+
+            for (uint c = 0; c < m_childCounts[slot]; ++c) {
+                m_changedSlots.push_back(m_firstChildren[slot] + c);
+            }
+        }
+
+        levelBegin = levelEnd;
+    }
+
+    m_dirtySlots.clear();
+}
+
+} // OGLW
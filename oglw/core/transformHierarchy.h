@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "core/types.h"
+
+namespace OGLW {
+
+// A hierarchy of transforms, the local translation, rotation and scale and the world matrices of
+// all the transforms are stored in contiguous arrays sorted by depth in the hierarchy, parents
+// before their children, and the children of a transform next to each other. update() walks the
+// depth levels in order and recomputes in parallel the world matrices of the transforms whose local
+// transform changed and of their descendants only, the cost is proportional to what moved. Transforms
+// are referred to by handles that stay valid while the arrays are reordered, a handle carries the
+// generation of its index so that it is no longer valid once its transform was destroyed, even when
+// the index was reused.
+class TransformHierarchy {
+public:
+    // index of the handle in the low 32 bits, generation in the high 32 bits
+    typedef uint64_t Handle;
+    static const Handle invalidHandle = ~0ull;
+
+    TransformHierarchy();
+
+    // create an identity transform, child of _parent when given
+    Handle create(Handle _parent = invalidHandle);
+    // destroy a transform, its descendants are destroyed with it on the next update, after which
+    // their handles aren't valid anymore either
+    void destroy(Handle _transform);
+    // attach a transform to another one, or make it a root with invalidHandle
+    void setParent(Handle _transform, Handle _parent);
+    Handle getParent(Handle _transform) const { return m_parentHandles[slotOf(_transform)]; }
+    bool isValid(Handle _transform) const;
+
+    void setPosition(Handle _transform, const glm::vec3& _position);
+    void setRotation(Handle _transform, const glm::quat& _rotation);
+    void setScale(Handle _transform, const glm::vec3& _scale);
+    const glm::vec3& getPosition(Handle _transform) const { return m_positions[slotOf(_transform)]; }
+    const glm::quat& getRotation(Handle _transform) const { return m_rotations[slotOf(_transform)]; }
+    const glm::vec3& getScale(Handle _transform) const { return m_scales[slotOf(_transform)]; }
+
+    // get the world matrix of a transform as of the last update
+    const glm::mat4& getWorldMatrix(Handle _transform) const { return m_worlds[slotOf(_transform)]; }
+    // whether the world matrix of a transform changed during the last update
+    bool hasChanged(Handle _transform) const { return m_changed[slotOf(_transform)]; }
+
+    // sort the transforms again after the hierarchy changed and update the world matrices
+    // whose local transform or one of their ancestors changed
+    void update();
+
+    // number of transforms
+    size_t size() const { return m_slots.size() - m_freeIndices.size(); }
+    // number of depth levels of the hierarchy, as of the last update
+    size_t getDepth() const { return m_levels.empty() ? 0 : m_levels.size() - 1; }
+
+private:
+    static const uint invalidSlot = ~0u;
+
+    static uint indexOf(Handle _transform) { return uint(_transform); }
+    static uint generationOf(Handle _transform) { return uint(_transform >> 32); }
+    uint slotOf(Handle _transform) const { return m_slots[indexOf(_transform)]; }
+
+    // mark a transform for update
+    void touch(uint _slot);
+    // sort the transforms by depth and the transforms of a level by parent, dropping the destroyed
+    // ones and their descendants
+    void sortByDepth();
+
+    // per transform arrays, indexed by slot
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::quat> m_rotations;
+    std::vector<glm::vec3> m_scales;
+    std::vector<glm::mat4> m_worlds;
+    // slot of the parent, valid once sorted
+    std::vector<uint> m_parents;
+    // slot of the first child in the next level and number of children, valid once sorted
+    std::vector<uint> m_firstChildren;
+    std::vector<uint> m_childCounts;
+    std::vector<Handle> m_parentHandles;
+    std::vector<Handle> m_handleOfSlot;
+    // destroyed since the last update
+    std::vector<uint8_t> m_destroyed;
+    // bytes rather than bits so that concurrent updates write separate memory locations
+    std::vector<uint8_t> m_localDirty;
+    std::vector<uint8_t> m_changed;
+
+    // slot of each handle index, invalidSlot for the free indices
+    std::vector<uint> m_slots;
+    // current generation of each handle index, incremented when the index is released
+    std::vector<uint> m_generations;
+    std::vector<uint> m_freeIndices;
+    // first slot of each depth level followed by the number of slots
+    std::vector<uint> m_levels;
+
+    // slots whose local transform changed since the last update
+    std::vector<uint> m_dirtySlots;
+    // slots whose world matrix changed during the last update, level by level
+    std::vector<uint> m_changedSlots;
+
+    // transforms were created, destroyed or reparented since the last update
+    bool m_hierarchyDirty;
+};
+
+} // OGLW
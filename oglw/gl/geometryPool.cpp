@@ -0,0 +1,240 @@
+#include "geometryPool.h"
+#include "core/log.h"
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
+namespace OGLW {
+
+static GLsizeiptr indexUnits(GLsizeiptr _bytes) {
+    return (_bytes + 3) / 4;
+}
+
+GeometryPool::GeometryPool(std::shared_ptr<VertexLayout> _vertexLayout, GLuint _vertexCapacity,
+    GLsizeiptr _indexCapacity) :
+    m_vertexLayout(_vertexLayout),
+    m_vertexAllocator(_vertexCapacity),
+    m_indexAllocator(indexUnits(_indexCapacity))
+{
+    std::vector<std::pair<GLintptr, GLsizeiptr>> noRanges;
+    std::vector<GLintptr> noDestinations;
+
+    m_glVertexBuffer = reallocate(0, GLsizeiptr(_vertexCapacity) * m_vertexLayout->getStride(),
+        noRanges, noDestinations);
+    m_glIndexBuffer = reallocate(0, m_indexAllocator.getSize() * 4, noRanges, noDestinations);
+}
+
+GeometryPool::~GeometryPool() {
+    GL_CHECK(glDeleteBuffers(1, &m_glVertexBuffer));
+    GL_CHECK(glDeleteBuffers(1, &m_glIndexBuffer));
+}
+
+std::shared_ptr<GeometryPool> GeometryPool::get(std::shared_ptr<VertexLayout> _vertexLayout) {
+    static std::unordered_map<std::string, std::weak_ptr<GeometryPool>> pools;
+
+    std::stringstream key;
+    key << _vertexLayout->getStride();
+    for (const auto& attrib : _vertexLayout->getAttributes()) {
+        key << ";" << attrib.name << "," << attrib.size << "," << attrib.type << "," << int(attrib.normalized)
+            << "," << attrib.location << "," << attrib.divisor;
+    }
+
+    auto& pool = pools[key.str()];
+    auto shared = pool.lock();
+
+    if (!shared) {
+        shared = std::make_shared<GeometryPool>(_vertexLayout);
+        pool = shared;
+    }
+
+    return shared;
+}
+
+GLuint GeometryPool::reallocate(GLuint _buffer, GLsizeiptr _newSize,
+    const std::vector<std::pair<GLintptr, GLsizeiptr>>& _ranges, const std::vector<GLintptr>& _destinations)
+{
+    GLuint buffer;
+
+    // use the copy targets not to modify the element array buffer binding of the bound vertex array
+    GL_CHECK(glGenBuffers(1, &buffer));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, buffer));
+    GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, _newSize, NULL, GL_STATIC_DRAW));
+
+    if (_buffer) {
+        GL_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, _buffer));
+
+        for (size_t i = 0; i < _ranges.size(); ++i) {
+            if (_ranges[i].second > 0) {
+                GL_CHECK(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                    _ranges[i].first, _destinations[i], _ranges[i].second));
+            }
+        }
+
+        GL_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+        GL_CHECK(glDeleteBuffers(1, &_buffer));
+    }
+
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+    return buffer;
+}
+
+void GeometryPool::growVertices(GLuint _nVertices) {
+    GLsizeiptr stride = m_vertexLayout->getStride();
+    size_t size = std::max(m_vertexAllocator.getSize() * 2, m_vertexAllocator.getSize() + _nVertices);
+    GLsizeiptr bytes = m_vertexAllocator.getSize() * stride;
+
+    INFO("Growing geometry pool vertex buffer to %d vertices\n", (int)size);
+
+    // the used ranges keep their offsets
+    m_glVertexBuffer = reallocate(m_glVertexBuffer, size * stride, { { 0, bytes } }, { 0 });
+    m_vertexAllocator.grow(size);
+    m_vao.reset();
+}
+
+void GeometryPool::growIndices(GLsizeiptr _nUnits) {
+    size_t size = std::max<size_t>(m_indexAllocator.getSize() * 2, m_indexAllocator.getSize() + _nUnits);
+    GLsizeiptr bytes = m_indexAllocator.getSize() * 4;
+
+    INFO("Growing geometry pool index buffer to %d bytes\n", (int)(size * 4));
+
+    m_glIndexBuffer = reallocate(m_glIndexBuffer, size * 4, { { 0, bytes } }, { 0 });
+    m_indexAllocator.grow(size);
+    m_vao.reset();
+}
+
+GeometryPool::Handle GeometryPool::allocate(GLuint _nVertices, GLsizeiptr _indexBytes) {
+    size_t vertexOffset, indexOffset;
+
+    if (!m_vertexAllocator.allocate(_nVertices, vertexOffset)) {
+        growVertices(_nVertices);
+        m_vertexAllocator.allocate(_nVertices, vertexOffset);
+    }
+
+    if (!m_indexAllocator.allocate(indexUnits(_indexBytes), indexOffset)) {
+        growIndices(indexUnits(_indexBytes));
+        m_indexAllocator.allocate(indexUnits(_indexBytes), indexOffset);
+    }
+
+    Handle handle;
+
+    if (m_freeHandles.empty()) {
+        handle = m_ranges.size();
+        m_ranges.emplace_back();
+        m_used.push_back(true);
+    } else {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_used[handle] = true;
+    }
+
+    m_ranges[handle] = { GLuint(vertexOffset), _nVertices, GLintptr(indexOffset * 4), _indexBytes };
+
+    return handle;
+}
+
+void GeometryPool::release(Handle _handle) {
+    if (_handle >= m_ranges.size() || !m_used[_handle]) {
+        WARN("Releasing an invalid geometry pool handle\n");
+        return;
+    }
+
+    const Range& range = m_ranges[_handle];
+
+    m_vertexAllocator.release(range.vertexOffset, range.vertexCount);
+    m_indexAllocator.release(range.indexByteOffset / 4, indexUnits(range.indexByteSize));
+    m_used[_handle] = false;
+    m_freeHandles.push_back(_handle);
+}
+
+void GeometryPool::uploadVertices(Handle _handle, const GLvoid* _data, GLintptr _byteOffset, GLsizeiptr _size) {
+    GLintptr start = GLintptr(m_ranges[_handle].vertexOffset) * m_vertexLayout->getStride();
+
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_glVertexBuffer));
+    GL_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, start + _byteOffset, _size, _data));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+}
+
+void GeometryPool::uploadIndices(Handle _handle, const GLvoid* _data, GLsizeiptr _size) {
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_glIndexBuffer));
+    GL_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, m_ranges[_handle].indexByteOffset, _size, _data));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+}
+
+void GeometryPool::defragment() {
+    std::vector<Handle> handles;
+
+    for (Handle handle = 0; handle < m_ranges.size(); ++handle) {
+        if (m_used[handle]) {
+            handles.push_back(handle);
+        }
+    }
+
+    GLsizeiptr stride = m_vertexLayout->getStride();
+    std::vector<std::pair<GLintptr, GLsizeiptr>> ranges;
+    std::vector<GLintptr> destinations;
+
+    // the ranges are packed in their current order, the allocators hand out consecutive offsets
+    // from the start of a single free block
+    std::sort(handles.begin(), handles.end(), [&](Handle _a, Handle _b) {
+        return m_ranges[_a].vertexOffset < m_ranges[_b].vertexOffset;
+    });
+
+    m_vertexAllocator.reset(m_vertexAllocator.getSize());
+
+    for (Handle handle : handles) {
+        Range& range = m_ranges[handle];
+        size_t offset;
+
+        m_vertexAllocator.allocate(range.vertexCount, offset);
+        ranges.push_back({ GLintptr(range.vertexOffset) * stride, GLsizeiptr(range.vertexCount) * stride });
+        destinations.push_back(offset * stride);
+        range.vertexOffset = offset;
+    }
+
+    m_glVertexBuffer = reallocate(m_glVertexBuffer, m_vertexAllocator.getSize() * stride, ranges, destinations);
+
+    ranges.clear();
+    destinations.clear();
+
+    std::sort(handles.begin(), handles.end(), [&](Handle _a, Handle _b) {
+        return m_ranges[_a].indexByteOffset < m_ranges[_b].indexByteOffset;
+    });
+
+    m_indexAllocator.reset(m_indexAllocator.getSize());
+
+    for (Handle handle : handles) {
+        Range& range = m_ranges[handle];
+        size_t offset;
+
+        m_indexAllocator.allocate(indexUnits(range.indexByteSize), offset);
+        ranges.push_back({ range.indexByteOffset, range.indexByteSize });
+        destinations.push_back(offset * 4);
+        range.indexByteOffset = offset * 4;
+    }
+
+    m_glIndexBuffer = reallocate(m_glIndexBuffer, m_indexAllocator.getSize() * 4, ranges, destinations);
+
+    m_vao.reset();
+}
+
+float GeometryPool::getFragmentation() const {
+    size_t freeSize = m_vertexAllocator.getFreeSize();
+
+    if (freeSize == 0) {
+        return 0.0f;
+    }
+
+    return 1.0f - float(m_vertexAllocator.getLargestFreeBlock()) / freeSize;
+}
+
+Vao& GeometryPool::getVao() {
+    if (!m_vao) {
+        m_vao = std::unique_ptr<Vao>(new Vao());
+        m_vao->init(m_glVertexBuffer, m_glIndexBuffer, *m_vertexLayout, m_vertexLayout->getLocations());
+    }
+
+    return *m_vao;
+}
+
+} // OGLW
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "gl/gl.h"
+#include "gl/vao.h"
+#include "gl/vertexLayout.h"
+#include "core/rangeAllocator.h"
+
+namespace OGLW {
+
+// Vertex and index buffers shared by the meshes of a vertex layout. Each mesh holds a handle to
+// a vertex range and an index range suballocated in the buffers, and all the meshes are drawn
+// through the same vertex array, with a base vertex and an index offset. The buffers grow when
+// a range doesn't fit, and defragment() packs the ranges to the start of the buffers, handles
+// stay valid and their ranges are read at draw time.
+class GeometryPool {
+public:
+    typedef uint Handle;
+    static const Handle invalidHandle = ~0u;
+
+    // a vertex and an index range of the pool
+    struct Range {
+        GLuint vertexOffset;
+        GLuint vertexCount;
+        GLintptr indexByteOffset;
+        GLsizeiptr indexByteSize;
+    };
+
+    GeometryPool(std::shared_ptr<VertexLayout> _vertexLayout, GLuint _vertexCapacity = 1 << 16,
+        GLsizeiptr _indexCapacity = 1 << 20);
+    ~GeometryPool();
+
+    // get the pool shared by the layouts with the same attributes and stride as _vertexLayout
+    static std::shared_ptr<GeometryPool> get(std::shared_ptr<VertexLayout> _vertexLayout);
+
+    // allocate _nVertices vertices and _indexBytes bytes of indices, growing the buffers when needed
+    Handle allocate(GLuint _nVertices, GLsizeiptr _indexBytes);
+    // release the ranges of an allocation
+    void release(Handle _handle);
+    // upload _size bytes of the vertices of an allocation, _byteOffset is relative to its vertex range
+    void uploadVertices(Handle _handle, const GLvoid* _data, GLintptr _byteOffset, GLsizeiptr _size);
+    // upload the indices of an allocation
+    void uploadIndices(Handle _handle, const GLvoid* _data, GLsizeiptr _size);
+    // get the ranges of an allocation, they change when the pool is defragmented
+    const Range& getRange(Handle _handle) const { return m_ranges[_handle]; }
+
+    // pack the allocations to the start of the buffers, merging the free space at their end
+    void defragment();
+    // ratio of the free vertex space not in the largest free block, 0 when packed
+    float getFragmentation() const;
+
+    // get the vertex array sourcing the pool buffers, created on first use
+    Vao& getVao();
+    // get the vertex layout of the pool
+    std::shared_ptr<VertexLayout> getVertexLayout() const { return m_vertexLayout; }
+    GLuint getVertexBuffer() const { return m_glVertexBuffer; }
+    GLuint getIndexBuffer() const { return m_glIndexBuffer; }
+
+private:
+    // reallocate a buffer to _newSize bytes, copying the _ranges (offset, size) of the old buffer
+    // at the offsets given by _destinations
+    static GLuint reallocate(GLuint _buffer, GLsizeiptr _newSize,
+        const std::vector<std::pair<GLintptr, GLsizeiptr>>& _ranges, const std::vector<GLintptr>& _destinations);
+    void growVertices(GLuint _nVertices);
+    void growIndices(GLsizeiptr _nUnits);
+
+    std::shared_ptr<VertexLayout> m_vertexLayout;
+    std::unique_ptr<Vao> m_vao;
+    GLuint m_glVertexBuffer;
+    GLuint m_glIndexBuffer;
+    // vertex space in vertices
+    RangeAllocator m_vertexAllocator;
+    // index space in 4 bytes units, to keep 32 bit indices aligned
+    RangeAllocator m_indexAllocator;
+    std::vector<Range> m_ranges;
+    std::vector<bool> m_used;
+    std::vector<Handle> m_freeHandles;
+};
+
+} // OGLW
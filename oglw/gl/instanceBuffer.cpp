@@ -0,0 +1,56 @@
+#include "instanceBuffer.h"
+#include "core/log.h"
+#include <algorithm>
+
+namespace OGLW {
+
+InstanceVbo::InstanceVbo(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _hint) :
+    m_vertexLayout(_vertexLayout),
+    m_glBuffer(0),
+    m_capacity(0),
+    m_nInstances(0),
+    m_hint(_hint),
+    m_dirty(false)
+{
+    for (const auto& attrib : m_vertexLayout->getAttributes()) {
+        if (attrib.divisor == 0) {
+            WARN("Instance attribute %s has no divisor, it is sourced per vertex\n", attrib.name.c_str());
+        }
+    }
+}
+
+InstanceVbo::~InstanceVbo() {
+    if (m_glBuffer) {
+        GL_CHECK(glDeleteBuffers(1, &m_glBuffer));
+    }
+}
+
+void InstanceVbo::bind() {
+    if (m_glBuffer == 0) {
+        GL_CHECK(glGenBuffers(1, &m_glBuffer));
+    }
+
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glBuffer));
+
+    if (!m_dirty) {
+        return;
+    }
+
+    GLsizeiptr bytes = GLsizeiptr(m_nInstances) * m_vertexLayout->getStride();
+
+    // grow geometrically so that adding instances doesn't reallocate every frame
+    if (bytes > m_capacity) {
+        m_capacity = std::max(bytes, m_capacity * 2);
+    }
+
+    // invalidate the data store on the driver, the draws of the previous frames keep the old storage
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_capacity, NULL, m_hint));
+
+    if (bytes > 0) {
+        GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, getInstanceData()));
+    }
+
+    m_dirty = false;
+}
+
+} // OGLW
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "gl/gl.h"
+#include "gl/vertexLayout.h"
+
+namespace OGLW {
+
+// A vertex buffer of per instance attributes, its layout attributes have a non null divisor.
+// The instance data is uploaded by orphaning the buffer storage, so that updating instances every
+// frame doesn't wait for the draws of the previous frame to complete.
+class InstanceVbo {
+public:
+    InstanceVbo(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _hint = GL_DYNAMIC_DRAW);
+    virtual ~InstanceVbo();
+
+    // number of instances in the buffer
+    GLsizei numInstances() const { return m_nInstances; }
+    // get the vertex layout of the instance attributes
+    std::shared_ptr<VertexLayout> getVertexLayout() const { return m_vertexLayout; }
+    // get the GL buffer handle, 0 until the first upload
+    GLuint getGlHandle() const { return m_glBuffer; }
+    // upload the instances if they were modified and bind the buffer to the array buffer target
+    void bind();
+
+protected:
+    // the instance data of the derived buffer, numInstances() times the layout stride
+    virtual const GLvoid* getInstanceData() const = 0;
+
+    std::shared_ptr<VertexLayout> m_vertexLayout;
+    GLuint m_glBuffer;
+    // size of the buffer storage in bytes
+    GLsizeiptr m_capacity;
+    GLsizei m_nInstances;
+    GLenum m_hint;
+    bool m_dirty;
+};
+
+// A typed instance buffer, T holds the attributes of one instance as described by the layout
+template <class T>
+class InstanceBuffer : public InstanceVbo {
+public:
+    InstanceBuffer(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _hint = GL_DYNAMIC_DRAW)
+        : InstanceVbo(_vertexLayout, _hint) {}
+
+    // add an instance
+    void add(const T& _instance) {
+        m_instances.push_back(_instance);
+        m_nInstances = m_instances.size();
+        m_dirty = true;
+    }
+    // replace all the instances
+    void set(std::vector<T> _instances) {
+        m_instances = std::move(_instances);
+        m_nInstances = m_instances.size();
+        m_dirty = true;
+    }
+    // modify an instance, the buffer is uploaded again on the next draw
+    T& operator[](size_t _index) {
+        m_dirty = true;
+        return m_instances[_index];
+    }
+    // remove all the instances, the buffer storage is kept
+    void clear() {
+        m_instances.clear();
+        m_nInstances = 0;
+        m_dirty = true;
+    }
+    // get the instances
+    const std::vector<T>& getInstances() const { return m_instances; }
+
+protected:
+    const GLvoid* getInstanceData() const override { return m_instances.data(); }
+
+private:
+    std::vector<T> m_instances;
+};
+
+} // OGLW
@@ -2,9 +2,12 @@
 
 #include "gl/glTypes.h"
 #include "gl/vboMesh.h"
+#include "gl/meshCache.h"
 #include <vector>
 #include <memory>
-#include "tiny_obj_loader.h"
+#include "core/objParser.h"
+#include "core/geometryProcessing.h"
+#include "core/parallel.h"
 #include "core/log.h"
 
 namespace OGLW {
@@ -13,18 +16,68 @@ template <class T> class Mesh : public VboMesh {
 public:
     Mesh(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode) : VboMesh(_vertexLayout, _drawMode){};
 
+    // reserve the arena for a total number of vertices and indices, avoids reallocations when appending
+    void reserve(size_t _nVertices, size_t _nIndices) {
+        m_vertices.reserve(_nVertices);
+        m_indices.reserve(_nIndices);
+    }
+
+    // append a batch of vertices, the indices are relative to the first vertex of the batch
     void addVertices(std::vector<T>&& _vertices, std::vector<int>&& _indices) {
-        vertices.push_back(_vertices);
-        indices.push_back(_indices);
+        beginSubmesh();
+
+        if (m_vertices.empty() && m_vertices.capacity() <= _vertices.capacity()) {
+            // first batch, take over its storage
+            m_vertices = std::move(_vertices);
+            m_nVertices = m_vertices.size();
+            m_submeshes.back().vertexCount = m_nVertices;
+        } else {
+            m_vertices.insert(m_vertices.end(), _vertices.begin(), _vertices.end());
+            m_nVertices += _vertices.size();
+            m_submeshes.back().vertexCount += _vertices.size();
+        }
+
+        for (int index : _indices) {
+            addIndex(index);
+        }
+    }
+
+    // start a new batch, the indices added after it are relative to its first vertex
+    void beginSubmesh() {
+        m_submeshes.push_back({ GLuint(m_nVertices), 0, GLuint(m_nIndices), 0 });
+    }
+
+    // append a vertex to the current batch
+    void addVertex(const T& _vertex) {
+        if (m_submeshes.empty()) {
+            beginSubmesh();
+        }
+
+        m_vertices.push_back(_vertex);
+        m_submeshes.back().vertexCount++;
+        m_nVertices++;
+    }
+
+    // append an index relative to the first vertex of the current batch
+    void addIndex(int _index) {
+        if (m_submeshes.empty()) {
+            beginSubmesh();
+        }
 
-        m_nVertices += _vertices.size();
-        m_nIndices += _indices.size();
+        m_indices.push_back(_index + m_submeshes.back().vertexOffset);
+        m_submeshes.back().indexCount++;
+        m_nIndices++;
     }
 
     virtual void compileVertexBuffer() override {
-        compile(vertices, indices);
+        compile(m_vertices, m_indices);
     }
 
+    // get the vertex arena, released once uploaded unless the mesh is dynamic
+    const std::vector<T>& getVertices() const { return m_vertices; }
+    // get the indices rebased on the arena, released once uploaded
+    const std::vector<GLuint>& getIndices() const { return m_indices; }
+
     void updateVertices(GLintptr _byteOffset, uint _nVerts, const T& _newVertexValue);
 
     template<class A>
@@ -33,6 +86,11 @@ public:
             return;
         }
 
+        if (m_isConverted) {
+            WARN("Can't update the attributes of a mesh converted to a compressed layout\n");
+            return;
+        }
+
         size_t aSize = sizeof(A);
         size_t tSize = sizeof(T);
 
@@ -57,12 +115,25 @@ protected:
 
     void setDirty(GLintptr _byteOffset, GLsizei _byteSize);
 
-    std::vector<std::vector<T>> vertices;
-    std::vector<std::vector<int>> indices;
+    virtual void releaseData(bool _keepVertices) override {
+        std::vector<GLuint>().swap(m_indices);
+
+        if (!_keepVertices) {
+            std::vector<T>().swap(m_vertices);
+        }
+    }
+
+    // the arena the mesh batches are appended to
+    std::vector<T> m_vertices;
+    // indices rebased on the arena
+    std::vector<GLuint> m_indices;
 };
 
 template<class T>
 void Mesh<T>::setDirty(GLintptr _byteOffset, GLsizei _byteSize) {
+    // the bounds are computed again on their next use
+    m_boundsDirty = true;
+
     if (!m_dirty) {
         m_dirtySize = _byteSize;
         m_dirtyOffset = _byteOffset;
@@ -80,6 +151,11 @@ void Mesh<T>::updateVertices(GLintptr _byteOffset, uint _nVerts, const T& _newVe
         return;
     }
 
+    if (m_isConverted) {
+        WARN("Can't update the vertices of a mesh converted to a compressed layout\n");
+        return;
+    }
+
     size_t tSize = sizeof(T);
 
     if (_nVerts * tSize + _byteOffset > m_nVertices * tSize) {
@@ -99,18 +175,48 @@ struct Vertex {
     glm::vec3 color;
     glm::vec3 normal;
     glm::vec2 uvs;
+    // the bitangent is tangent.w * cross(normal, tangent.xyz), zero when the mesh has no uvs
+    glm::vec4 tangent;
 };
 
 typedef Mesh<Vertex> RawMesh;
 
-static std::unique_ptr<RawMesh> loadOBJ(std::string _path) {
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
+struct OBJLoadOptions {
+    // drop the vertex color attribute, the loader never fills it
+    bool stripColor = false;
+    // store half float positions and uvs and packed 2_10_10_10 normals on the gpu
+    bool quantize = false;
+    // weld the vertices and reorder them for the vertex cache, overdraw and vertex fetch
+    bool optimize = false;
+    // number of simplified levels of detail to generate, each with half the triangles of the previous one
+    uint lodLevels = 0;
+    // read the compiled mesh from a binary cache next to the source file, the cache is written when
+    // missing or out of date, which needs a writable asset directory and compiles the mesh before
+    // returning it, the cache is memory mapped and only available on posix systems
+    bool useCache = false;
+};
+
+static std::unique_ptr<RawMesh> loadOBJ(std::string _path, OBJLoadOptions _options = {}) {
+    std::string cachePath = _path + ".oglwmesh";
+    uint32_t cacheOptions = _options.stripColor | _options.quantize << 1 | _options.optimize << 2
+        | _options.lodLevels << 8;
+    MeshCacheKey cacheKey;
+    bool useCache = _options.useCache && MeshCache::makeKey(_path, cacheOptions, cacheKey);
 
-    std::string err = tinyobj::LoadObj(shapes, materials, _path.c_str(), NULL);
+    if (useCache) {
+        auto mesh = std::unique_ptr<RawMesh>(new RawMesh(nullptr, GL_TRIANGLES));
 
-    if (!err.empty()) {
-        std::cerr << err << std::endl;
+        if (MeshCache::read(*mesh, cachePath, cacheKey)) {
+            return mesh;
+        }
+    }
+
+    std::vector<ObjShape> shapes;
+
+    bool parsed = parseOBJ(_path, shapes);
+
+    if (!parsed) {
+        WARN("Failed to load OBJ file %s\n", _path.c_str());
     }
 
     auto layout = std::shared_ptr<OGLW::VertexLayout>(new OGLW::VertexLayout({
@@ -118,78 +224,153 @@ static std::unique_ptr<RawMesh> loadOBJ(std::string _path) {
         {"color", 3, GL_FLOAT, false, 0, AttributeLocation::color},
         {"normal", 3, GL_FLOAT, false, 0, AttributeLocation::normal},
         {"uv", 2, GL_FLOAT, false, 0, AttributeLocation::uv},
+        {"tangent", 4, GL_FLOAT, false, 0, AttributeLocation::tangent},
     }));
 
     std::vector<std::unique_ptr<RawMesh>> meshes;
 
     auto mesh = std::unique_ptr<RawMesh>(new RawMesh(layout, GL_TRIANGLES));
 
-    for (size_t i = 0; i < shapes.size(); i++) {
-        std::vector<Vertex> vertices;
-        std::vector<int> indices;
-        bool hasNormals = true;
-        bool hasUVs = true;
+    mesh->setOptimize(_options.optimize);
+    mesh->setLodLevels(_options.lodLevels);
+
+    if (_options.stripColor || _options.quantize) {
+        std::vector<VertexAttrib> attribs;
 
-        assert((shapes[i].mesh.indices.size() % 3) == 0);
-        for (size_t f = 0; f < shapes[i].mesh.indices.size() / 3; f++) {
-            indices.push_back(shapes[i].mesh.indices[3 * f + 0]);
-            indices.push_back(shapes[i].mesh.indices[3 * f + 1]);
-            indices.push_back(shapes[i].mesh.indices[3 * f + 2]);
+        // positions are padded to 4 components to keep the attributes 4 bytes aligned
+        if (_options.quantize) {
+            attribs.push_back({"position", 4, GL_HALF_FLOAT, false, 0, AttributeLocation::position});
+        } else {
+            attribs.push_back({"position", 3, GL_FLOAT, false, 0, AttributeLocation::position});
         }
-        assert((shapes[i].mesh.positions.size() % 3) == 0);
 
-        if (shapes[i].mesh.normals.size() == 0) {
-            hasNormals = false;
+        if (!_options.stripColor) {
+            if (_options.quantize) {
+                attribs.push_back({"color", 4, GL_UNSIGNED_BYTE, true, 0, AttributeLocation::color});
+            } else {
+                attribs.push_back({"color", 3, GL_FLOAT, false, 0, AttributeLocation::color});
+            }
         }
 
-        if (shapes[i].mesh.texcoords.size() == 0) {
-            hasUVs = false;
+        if (_options.quantize) {
+            attribs.push_back({"normal", 4, GL_INT_2_10_10_10_REV, true, 0, AttributeLocation::normal});
+            attribs.push_back({"uv", 2, GL_HALF_FLOAT, false, 0, AttributeLocation::uv});
+            attribs.push_back({"tangent", 4, GL_INT_2_10_10_10_REV, true, 0, AttributeLocation::tangent});
+        } else {
+            attribs.push_back({"normal", 3, GL_FLOAT, false, 0, AttributeLocation::normal});
+            attribs.push_back({"uv", 2, GL_FLOAT, false, 0, AttributeLocation::uv});
+            attribs.push_back({"tangent", 4, GL_FLOAT, false, 0, AttributeLocation::tangent});
         }
-        for (size_t v = 0; v < shapes[i].mesh.positions.size() / 3; v++) {
-            glm::vec2 uv;
-            glm::vec3 normal;
-            glm::vec3 position;
-            glm::vec3 color;
 
+        mesh->setCompressedLayout(std::make_shared<VertexLayout>(attribs));
+    }
+
+    size_t nVertices = 0;
+    size_t nIndices = 0;
+
+    for (const auto& shape : shapes) {
+        nVertices += shape.positions.size() / 3;
+        nIndices += shape.indices.size();
+    }
+
+    mesh->reserve(nVertices, nIndices);
+
+    for (auto& shape : shapes) {
+        std::vector<Vertex> vertices(shape.positions.size() / 3);
+        std::vector<int> indices(shape.indices.begin(), shape.indices.end());
+        bool hasNormals = !shape.normals.empty();
+        bool hasUVs = !shape.texcoords.empty();
+
+        Vec3Array positions;
+        Vec3Array normals;
+        Vec3Array tangents;
+        std::vector<float> handedness;
+
+        // the positions compute the missing normals, and the tangents used by normal mapping when the shape has uvs
+        if (!hasNormals || hasUVs) {
+            positions.resize(vertices.size());
+
+            parallelFor(0, vertices.size(), 1 << 16, [&](size_t _begin, size_t _end) {
+                for (size_t v = _begin; v < _end; ++v) {
+                    positions.x[v] = shape.positions[3 * v + 0];
+                    positions.y[v] = shape.positions[3 * v + 1];
+                    positions.z[v] = shape.positions[3 * v + 2];
+                }
+            });
+        }
+
+        if (hasNormals) {
             if (hasUVs) {
-                uv = {
-                    shapes[i].mesh.texcoords[2 * v + 0],
-                    shapes[i].mesh.texcoords[2 * v + 1]
-                };
+                normals.resize(vertices.size());
+
+                parallelFor(0, vertices.size(), 1 << 16, [&](size_t _begin, size_t _end) {
+                    for (size_t v = _begin; v < _end; ++v) {
+                        normals.x[v] = shape.normals[3 * v + 0];
+                        normals.y[v] = shape.normals[3 * v + 1];
+                        normals.z[v] = shape.normals[3 * v + 2];
+                    }
+                });
             }
+        } else {
+            computeNormals(positions, shape.indices, normals);
+        }
 
-            if (hasNormals) {
-                normal = {
-                    shapes[i].mesh.normals[3 * v + 0],
-                    shapes[i].mesh.normals[3 * v + 1],
-                    shapes[i].mesh.normals[3 * v + 2]
-                };
-            }
+        if (hasUVs) {
+            Vec2Array uvs;
+            uvs.resize(vertices.size());
 
-            position = {
-                shapes[i].mesh.positions[3 * v + 0],
-                shapes[i].mesh.positions[3 * v + 1],
-                shapes[i].mesh.positions[3 * v + 2]
-            };
+            parallelFor(0, vertices.size(), 1 << 16, [&](size_t _begin, size_t _end) {
+                for (size_t v = _begin; v < _end; ++v) {
+                    uvs.x[v] = shape.texcoords[2 * v + 0];
+                    uvs.y[v] = shape.texcoords[2 * v + 1];
+                }
+            });
 
-            vertices.push_back({ position, color, normal, uv });
+            computeTangents(positions, normals, uvs, shape.indices, tangents, handedness);
         }
 
-        if (!hasNormals) {
-            std::vector<glm::vec3> verts;
-            verts.resize(vertices.size());
-            for (int j = 0; j < vertices.size(); ++j) {
-                verts[j] = vertices[j].position;
-            }
-            auto normals = VboMesh::computeNormals(verts, indices);
-            for (int j = 0; j < vertices.size(); ++j) {
-                vertices[j].normal = normals[j];
+        parallelFor(0, vertices.size(), 1 << 16, [&](size_t _begin, size_t _end) {
+            for (size_t v = _begin; v < _end; ++v) {
+                Vertex& vertex = vertices[v];
+
+                vertex.position = {
+                    shape.positions[3 * v + 0],
+                    shape.positions[3 * v + 1],
+                    shape.positions[3 * v + 2]
+                };
+
+                if (hasNormals) {
+                    vertex.normal = {
+                        shape.normals[3 * v + 0],
+                        shape.normals[3 * v + 1],
+                        shape.normals[3 * v + 2]
+                    };
+                } else {
+                    vertex.normal = { normals.x[v], normals.y[v], normals.z[v] };
+                }
+
+                if (hasUVs) {
+                    vertex.uvs = {
+                        shape.texcoords[2 * v + 0],
+                        shape.texcoords[2 * v + 1]
+                    };
+                    vertex.tangent = { tangents.x[v], tangents.y[v], tangents.z[v], handedness[v] };
+                }
             }
-        }
+        });
+
+        // release the parsed attributes before the next shape
+        shape = ObjShape();
 
         mesh->addVertices(std::move(vertices), std::move(indices));
     }
 
+    // an empty mesh from a failed parse is never cached
+    if (useCache && parsed) {
+        mesh->compileVertexBuffer();
+        MeshCache::write(*mesh, cachePath, cacheKey);
+    }
+
     return std::move(mesh);
 }
 
@@ -0,0 +1,270 @@
+#include "meshCache.h"
+#include "gl/gl.h"
+#include "core/mappedFile.h"
+#include "core/log.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+
+namespace OGLW {
+
+namespace {
+
+const char meshCacheMagic[4] = { 'O', 'G', 'L', 'M' };
+// bump when the layout of the cache or the vertices written by the loaders change
+const uint32_t meshCacheVersion = 3;
+// alignment of the vertex and index blobs in the file
+const uint64_t meshCacheAlignment = 16;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint32_t options;
+    uint32_t drawMode;
+    uint32_t indexType;
+    uint32_t converted;
+    uint32_t nAttributes;
+    uint32_t nVertices;
+    uint32_t nIndices;
+    uint32_t nSubmeshes;
+    uint32_t nLods;
+    uint32_t nIndexChunks;
+    float boundsMin[3];
+    float boundsMax[3];
+    float boundsCenter[3];
+    float boundsRadius;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t size;
+};
+
+struct Attribute {
+    char name[32];
+    int32_t size;
+    uint32_t type;
+    uint32_t normalized;
+    uint32_t location;
+};
+
+struct IndexChunk {
+    uint64_t byteOffset;
+    int32_t count;
+    int32_t baseVertex;
+    uint32_t lod;
+    uint32_t padding;
+};
+
+uint64_t align(uint64_t _offset) {
+    return (_offset + meshCacheAlignment - 1) & ~(meshCacheAlignment - 1);
+}
+
+uint64_t tablesSize(const Header& _header) {
+    return sizeof(Header)
+        + uint64_t(_header.nAttributes) * sizeof(Attribute)
+        + uint64_t(_header.nSubmeshes) * sizeof(VboMesh::Submesh)
+        + uint64_t(_header.nLods) * sizeof(VboMesh::Lod)
+        + uint64_t(_header.nIndexChunks) * sizeof(IndexChunk);
+}
+
+} // anonymous
+
+bool MeshCache::makeKey(const std::string& _sourcePath, uint32_t _options, MeshCacheKey& _key) {
+    struct stat info;
+
+    if (stat(_sourcePath.c_str(), &info) != 0) {
+        return false;
+    }
+
+    _key.sourceSize = info.st_size;
+    _key.sourceTime = info.st_mtime;
+    _key.options = _options;
+
+    return true;
+}
+
+bool MeshCache::write(const VboMesh& _mesh, const std::string& _path, const MeshCacheKey& _key) {
+    if (!_mesh.m_isCompiled || _mesh.m_isUploaded || !_mesh.m_glVertexData) {
+        WARN("Only compiled meshes not yet uploaded can be cached\n");
+        return false;
+    }
+
+    const auto& attributes = _mesh.m_vertexLayout->getAttributes();
+    GLsizeiptr indexSize = _mesh.m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    uint64_t vertexBytes = uint64_t(_mesh.m_nVertices) * _mesh.m_vertexLayout->getStride();
+    uint64_t indexBytes = _mesh.m_glIndexData ? uint64_t(_mesh.m_nIndices) * indexSize : 0;
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, meshCacheMagic, sizeof(meshCacheMagic));
+    header.version = meshCacheVersion;
+    header.sourceSize = _key.sourceSize;
+    header.sourceTime = _key.sourceTime;
+    header.options = _key.options;
+    header.drawMode = _mesh.m_drawMode;
+    header.indexType = _mesh.m_indexType;
+    header.converted = _mesh.m_isConverted;
+    header.nAttributes = attributes.size();
+    header.nVertices = _mesh.m_nVertices;
+    header.nIndices = indexBytes > 0 ? _mesh.m_nIndices : 0;
+    header.nSubmeshes = _mesh.m_submeshes.size();
+    header.nLods = _mesh.m_lods.size();
+    header.nIndexChunks = _mesh.m_indexChunks.size();
+
+    for (int i = 0; i < 3; ++i) {
+        header.boundsMin[i] = _mesh.m_bounds.min[i];
+        header.boundsMax[i] = _mesh.m_bounds.max[i];
+        header.boundsCenter[i] = _mesh.m_bounds.center[i];
+    }
+    header.boundsRadius = _mesh.m_bounds.radius;
+
+    header.vertexOffset = align(tablesSize(header));
+    header.indexOffset = align(header.vertexOffset + vertexBytes);
+    header.size = header.indexOffset + indexBytes;
+
+    std::ofstream file(_path, std::ofstream::binary | std::ofstream::trunc);
+
+    if (!file.is_open()) {
+        WARN("Can't write mesh cache %s\n", _path.c_str());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& attribute : attributes) {
+        Attribute cached;
+        std::memset(&cached, 0, sizeof(cached));
+        std::strncpy(cached.name, attribute.name.c_str(), sizeof(cached.name) - 1);
+        cached.size = attribute.size;
+        cached.type = attribute.type;
+        cached.normalized = attribute.normalized;
+        cached.location = attribute.location;
+        file.write(reinterpret_cast<const char*>(&cached), sizeof(cached));
+    }
+
+    file.write(reinterpret_cast<const char*>(_mesh.m_submeshes.data()), header.nSubmeshes * sizeof(VboMesh::Submesh));
+    file.write(reinterpret_cast<const char*>(_mesh.m_lods.data()), header.nLods * sizeof(VboMesh::Lod));
+
+    for (const auto& chunk : _mesh.m_indexChunks) {
+        IndexChunk cached = { uint64_t(chunk.byteOffset), chunk.count, chunk.baseVertex, chunk.lod, 0 };
+        file.write(reinterpret_cast<const char*>(&cached), sizeof(cached));
+    }
+
+    const char padding[meshCacheAlignment] = {};
+
+    file.write(padding, header.vertexOffset - tablesSize(header));
+    file.write(reinterpret_cast<const char*>(_mesh.m_glVertexData), vertexBytes);
+    file.write(padding, header.indexOffset - header.vertexOffset - vertexBytes);
+
+    if (indexBytes > 0) {
+        file.write(reinterpret_cast<const char*>(_mesh.m_glIndexData), indexBytes);
+    }
+
+    if (!file.good()) {
+        WARN("Failed to write mesh cache %s\n", _path.c_str());
+        file.close();
+        std::remove(_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshCache::read(VboMesh& _mesh, const std::string& _path, const MeshCacheKey& _key) {
+    if (_mesh.m_isCompiled) {
+        WARN("Mesh caches can only be read into meshes not yet compiled\n");
+        return false;
+    }
+
+    auto mapping = std::unique_ptr<MappedFile>(new MappedFile(_path));
+
+    if (!mapping->isValid() || mapping->getSize() < sizeof(Header)) {
+        return false;
+    }
+
+    const uchar* data = mapping->getData();
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+
+    uint64_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+    if (std::memcmp(header.magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0
+        || header.version != meshCacheVersion
+        || header.size != mapping->getSize()
+        || tablesSize(header) > header.vertexOffset
+        || header.vertexOffset > header.indexOffset
+        || header.indexOffset + header.nIndices * indexSize > header.size) {
+        WARN("Ignoring invalid mesh cache %s\n", _path.c_str());
+        return false;
+    }
+
+    if (header.sourceSize != _key.sourceSize || header.sourceTime != _key.sourceTime
+        || header.options != _key.options) {
+        INFO("Mesh cache %s is out of date\n", _path.c_str());
+        return false;
+    }
+
+    const uchar* tables = data + sizeof(Header);
+    std::vector<VertexAttrib> attributes;
+
+    for (uint i = 0; i < header.nAttributes; ++i) {
+        Attribute cached;
+        std::memcpy(&cached, tables, sizeof(cached));
+        tables += sizeof(cached);
+
+        cached.name[sizeof(cached.name) - 1] = '\0';
+        attributes.push_back({ cached.name, cached.size, cached.type, GLboolean(cached.normalized), 0,
+            cached.location });
+    }
+
+    auto layout = std::make_shared<VertexLayout>(attributes);
+
+    if (uint64_t(header.nVertices) * layout->getStride() > header.indexOffset - header.vertexOffset) {
+        WARN("Ignoring invalid mesh cache %s\n", _path.c_str());
+        return false;
+    }
+
+    _mesh.m_submeshes.resize(header.nSubmeshes);
+    std::memcpy(_mesh.m_submeshes.data(), tables, header.nSubmeshes * sizeof(VboMesh::Submesh));
+    tables += header.nSubmeshes * sizeof(VboMesh::Submesh);
+
+    _mesh.m_lods.resize(header.nLods);
+    std::memcpy(_mesh.m_lods.data(), tables, header.nLods * sizeof(VboMesh::Lod));
+    tables += header.nLods * sizeof(VboMesh::Lod);
+
+    _mesh.m_indexChunks.clear();
+    for (uint i = 0; i < header.nIndexChunks; ++i) {
+        IndexChunk cached;
+        std::memcpy(&cached, tables, sizeof(cached));
+        tables += sizeof(cached);
+
+        _mesh.m_indexChunks.push_back({ GLintptr(cached.byteOffset), cached.count, cached.baseVertex, cached.lod });
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        _mesh.m_bounds.min[i] = header.boundsMin[i];
+        _mesh.m_bounds.max[i] = header.boundsMax[i];
+        _mesh.m_bounds.center[i] = header.boundsCenter[i];
+    }
+    _mesh.m_bounds.radius = header.boundsRadius;
+    _mesh.m_boundsDirty = false;
+
+    _mesh.m_vertexLayout = layout;
+    _mesh.setDrawMode(header.drawMode);
+    _mesh.m_nVertices = header.nVertices;
+    _mesh.m_nIndices = header.nIndices;
+    _mesh.m_indexType = header.indexType;
+    _mesh.m_isConverted = header.converted;
+    _mesh.m_glVertexData = reinterpret_cast<GLbyte*>(mapping->getData() + header.vertexOffset);
+    _mesh.m_glIndexData = header.nIndices > 0
+        ? reinterpret_cast<const GLbyte*>(mapping->getData() + header.indexOffset)
+        : nullptr;
+    _mesh.m_mappedFile = std::move(mapping);
+    _mesh.m_isCompiled = true;
+
+    return true;
+}
+
+} // OGLW
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "gl/vboMesh.h"
+
+namespace OGLW {
+
+// identifies the source a mesh cache was built from, the cache is ignored when it doesn't match
+struct MeshCacheKey {
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    // the options the source was loaded with
+    uint32_t options;
+};
+
+// Versioned binary mesh format holding the compiled data of a mesh: the vertex layout,
+// the interleaved vertices and the indices as uploaded, the bounds, submeshes, levels of detail
+// and index chunks. Reading maps the file and points the mesh at it, so that it's uploaded
+// with no parsing nor copy.
+class MeshCache {
+public:
+    // build the key of a source file, false if the file can't be found
+    static bool makeKey(const std::string& _sourcePath, uint32_t _options, MeshCacheKey& _key);
+    // write the compiled data of a mesh, the mesh should be compiled and not yet uploaded
+    static bool write(const VboMesh& _mesh, const std::string& _path, const MeshCacheKey& _key);
+    // load a cache into an empty mesh, false if the cache is missing, invalid or out of date
+    static bool read(VboMesh& _mesh, const std::string& _path, const MeshCacheKey& _key);
+};
+
+} // OGLW
@@ -0,0 +1,116 @@
+#include "occlusionQuery.h"
+#include "gl/renderState.h"
+#include "gl/shader.h"
+#include "core/geometries.h"
+#include <vector>
+#include <memory>
+
+namespace OGLW {
+namespace OcclusionQuery {
+
+static std::vector<GLuint> freeQueries;
+static std::unique_ptr<Shader> proxyShader;
+static std::unique_ptr<RawMesh> proxyBox;
+
+GLuint acquire() {
+    if (freeQueries.empty()) {
+        GLuint query;
+        GL_CHECK(glGenQueries(1, &query));
+        return query;
+    }
+
+    GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+
+    return query;
+}
+
+void release(GLuint _query) {
+    freeQueries.push_back(_query);
+}
+
+GLenum target() {
+    // conservative queries may report samples for a fully hidden box but skip the exact
+    // per sample count, cheaper on the hardware supporting them
+    static GLenum target = GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility ?
+        GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+    return target;
+}
+
+bool crossesNearPlane(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _modelViewProjection) {
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 p = _modelViewProjection * glm::vec4(corner & 1 ? _max.x : _min.x, corner & 2 ? _max.y : _min.y,
+            corner & 4 ? _max.z : _min.z, 1.0f);
+
+        // the near plane of a reverse Z projection is at z = w
+        if (p.z < -p.w || p.z > p.w || p.w <= 0.0f) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void drawProxy(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _modelViewProjection) {
+    if (!proxyShader) {
+        static const std::string shaderProgramBundle = R"END(
+            #pragma begin:vertex
+            #version 330
+
+            in vec3 position;
+
+            uniform mat4 mvp;
+            uniform vec3 boxCenter;
+            uniform vec3 boxExtent;
+
+            void main() {
+                gl_Position = mvp * vec4(boxCenter + position * boxExtent, 1.0);
+            }
+            #pragma end:vertex
+
+            #pragma begin:fragment
+            #version 330
+
+            out vec4 outColour;
+
+            void main(void) {
+                outColour = vec4(1.0);
+            }
+            #pragma end:fragment
+        )END";
+
+        proxyShader = std::make_unique<Shader>();
+        proxyShader->loadBundleSource(shaderProgramBundle);
+        proxyBox = cube(1.0f);
+    }
+
+    RenderState::push();
+
+    // the box faces are drawn from both sides so that the query doesn't depend on the winding
+    RenderState::depthTest(GL_TRUE);
+    RenderState::depthWrite(GL_FALSE);
+    RenderState::colorWrite(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    RenderState::culling(GL_FALSE);
+
+    proxyShader->setUniform("mvp", _modelViewProjection);
+    proxyShader->setUniform("boxCenter", (_min + _max) * 0.5f);
+    proxyShader->setUniform("boxExtent", (_max - _min) * 0.5f);
+    proxyBox->draw(*proxyShader);
+
+    RenderState::pop();
+}
+
+void releaseResources() {
+    if (!freeQueries.empty()) {
+        GL_CHECK(glDeleteQueries(freeQueries.size(), freeQueries.data()));
+    }
+
+    // release the storage too, the statics outlive the context
+    std::vector<GLuint>().swap(freeQueries);
+    proxyShader.reset();
+    proxyBox.reset();
+}
+
+} // OcclusionQuery
+} // OGLW
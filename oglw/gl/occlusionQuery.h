@@ -0,0 +1,27 @@
+#pragma once
+
+#include "gl/gl.h"
+#include "glm/glm.hpp"
+
+namespace OGLW {
+
+// Occlusion query objects shared by the meshes and the bounding box drawn in them. Query objects
+// are recycled through a pool instead of being generated and deleted per draw.
+namespace OcclusionQuery {
+
+// get a query object from the pool
+GLuint acquire();
+// give a query object back to the pool
+void release(GLuint _query);
+// the query target, GL_ANY_SAMPLES_PASSED_CONSERVATIVE when available and GL_ANY_SAMPLES_PASSED otherwise
+GLenum target();
+// whether the box [_min, _max] transformed by _modelViewProjection crosses the near or the far
+// plane, its faces can't be rasterized as a proxy then
+bool crossesNearPlane(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _modelViewProjection);
+// draw the box [_min, _max] transformed by _modelViewProjection, depth tested without writing color nor depth
+void drawProxy(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _modelViewProjection);
+// delete the pooled query objects and the proxy resources, called while the GL context is alive
+void releaseResources();
+
+} // OcclusionQuery
+} // OGLW
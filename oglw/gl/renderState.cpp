@@ -5,27 +5,30 @@
 namespace OGLW {
 namespace RenderState {
 
-#define RENDER_STATES           \
-Blending blending;              \
-DepthTest depthTest;            \
-StencilTest stencilTest;        \
-Culling culling;                \
-DepthWrite depthWrite;          \
-DepthFunc depthFunc;            \
-BlendingFunc blendingFunc;      \
-StencilWrite stencilWrite;      \
-StencilFunc stencilFunc;        \
-StencilOp stencilOp;            \
-ColorWrite colorWrite;          \
-FrontFace frontFace;            \
-CullFace cullFace;              \
-ClearDepth clearDepth;          \
-DepthRange depthRange;          \
-ShaderProgram shaderProgram;    \
-TextureUnit textureUnit;        \
-Texture texture;                \
-DrawBuffer drawBuffer;          \
-ReadBuffer readBuffer;
+#define RENDER_STATES              \
+Blending blending;                 \
+DepthTest depthTest;               \
+StencilTest stencilTest;           \
+Culling culling;                   \
+DepthWrite depthWrite;             \
+DepthFunc depthFunc;               \
+BlendingFunc blendingFunc;         \
+StencilWrite stencilWrite;         \
+StencilFunc stencilFunc;           \
+StencilOp stencilOp;               \
+ColorWrite colorWrite;             \
+FrontFace frontFace;               \
+CullFace cullFace;                 \
+ClearDepth clearDepth;             \
+DepthRange depthRange;             \
+ShaderProgram shaderProgram;       \
+TextureUnit textureUnit;           \
+Texture texture;                   \
+DrawBuffer drawBuffer;             \
+ReadBuffer readBuffer;             \
+BlendingEquation blendingEquation; \
+ScissorTest scissorTest;           \
+Scissor scissor;
 
 RENDER_STATES
 
@@ -67,6 +70,10 @@ void initialize() {
     RenderState::cullFace.init(GL_BACK);
     RenderState::frontFace.init(GL_CCW);
     RenderState::blending.init(false);
+    RenderState::blendingEquation.init(GL_FUNC_ADD);
+    RenderState::scissorTest.init(false);
+    RenderState::scissor.init(0, 0, 0, 0);
+    RenderState::colorWrite.init(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     RenderState::drawBuffer.init(GL_BACK);
     RenderState::readBuffer.init(GL_BACK);
     RenderState::shaderProgram.init(std::numeric_limits<unsigned int>::max(), false);
@@ -80,7 +87,8 @@ void push() {
         depthWrite, depthFunc, blendingFunc, stencilWrite,
         stencilFunc, stencilOp, colorWrite, frontFace,
         cullFace, clearDepth, depthRange, shaderProgram,
-        textureUnit, texture, drawBuffer, readBuffer
+        textureUnit, texture, drawBuffer, readBuffer,
+        blendingEquation, scissorTest, scissor
     });
 }
 
@@ -100,6 +108,12 @@ void pop() {
     RenderState::cullFace(desc.cullFace.get<0>());
     RenderState::frontFace(desc.frontFace.get<0>());
     RenderState::blending(desc.blending.get());
+    RenderState::blendingEquation(desc.blendingEquation.get<0>());
+    RenderState::scissorTest(desc.scissorTest.get());
+    RenderState::scissor(desc.scissor.get<0>(), desc.scissor.get<1>(),
+        desc.scissor.get<2>(), desc.scissor.get<3>());
+    RenderState::colorWrite(desc.colorWrite.get<0>(), desc.colorWrite.get<1>(),
+        desc.colorWrite.get<2>(), desc.colorWrite.get<3>());
     RenderState::drawBuffer(desc.drawBuffer.get<0>());
     RenderState::readBuffer(desc.readBuffer.get<0>());
 
@@ -100,9 +100,11 @@ using DepthTest = State<BoolSwitch<GL_DEPTH_TEST>>;
 using StencilTest = State<BoolSwitch<GL_STENCIL_TEST>>;
 using Blending = State<BoolSwitch<GL_BLEND>>;
 using Culling = State<BoolSwitch<GL_CULL_FACE>>;
+using ScissorTest = State<BoolSwitch<GL_SCISSOR_TEST>>;
 using DepthWrite = StateWrap<FUN(glDepthMask), GLboolean>;
 using DepthFunc = StateWrap<FUN(glDepthFunc), GLenum>;
 using BlendingFunc = StateWrap<FUN(glBlendFunc), GLenum, GLenum>;
+using BlendingEquation = StateWrap<FUN(glBlendEquation), GLenum>;
 using StencilWrite = StateWrap<FUN(glStencilMask), GLuint>;
 using StencilFunc = StateWrap<FUN(glStencilFunc), GLenum, GLint, GLuint>;
 using StencilOp = StateWrap<FUN(glStencilOp), GLenum, GLenum, GLenum>;
@@ -116,11 +118,13 @@ using TextureUnit = StateWrap<FUN(activeTextureUnit), GLuint>;
 using Texture = StateWrap<FUN(bindTexture), GLenum, GLuint>;
 using DrawBuffer = StateWrap<FUN(glDrawBuffer), GLenum>;
 using ReadBuffer = StateWrap<FUN(glReadBuffer), GLenum>;
+using Scissor = StateWrap<FUN(glScissor), GLint, GLint, GLsizei, GLsizei>;
 
 extern DepthTest depthTest;
 extern DepthWrite depthWrite;
 extern Blending blending;
 extern BlendingFunc blendingFunc;
+extern BlendingEquation blendingEquation;
 extern DepthFunc depthFunc;
 extern StencilTest stencilTest;
 extern StencilWrite stencilWrite;
@@ -137,6 +141,8 @@ extern TextureUnit textureUnit;
 extern Texture texture;
 extern DrawBuffer drawBuffer;
 extern ReadBuffer readBuffer;
+extern ScissorTest scissorTest;
+extern Scissor scissor;
 
 } // RenderState
 } // OGLW
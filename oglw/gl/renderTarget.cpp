@@ -7,6 +7,9 @@ namespace OGLW {
 RenderTarget::RenderTarget(RenderTargetSetup _setup) {
     m_renderBuffer = 0;
     m_fbo = 0;
+    m_resolveFbo = 0;
+    m_width = 0;
+    m_height = 0;
     m_setup = _setup;
     m_isValid = _setup.isValid();
 }
@@ -20,34 +23,114 @@ void RenderTarget::create(uint _width, uint _height) {
         WARN("Invalid render target\n");
     }
 
+    if (m_setup.samples > 1) {
+        GLint maxSamples = 0;
+        GL_CHECK(glGetIntegerv(GL_MAX_SAMPLES, &maxSamples));
+
+        if (m_setup.samples > (uint)maxSamples) {
+            WARN("Render target requests %d samples, only %d are supported\n", m_setup.samples, maxSamples);
+            m_setup.samples = maxSamples;
+        }
+    }
+
     GLint framebufferBound = 0;
     GL_CHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferBound));
 
+    m_width = _width;
+    m_height = _height;
+
+    if (isMultisampled()) {
+        // the sampleable textures live in the resolve framebuffer, the multisampled
+        // framebuffer only holds render buffers
+        GL_CHECK(glGenFramebuffers(1, &m_resolveFbo));
+        GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_resolveFbo));
+
+        createTextures(_width, _height);
+        checkStatus();
+    }
+
     GL_CHECK(glGenFramebuffers(1, &m_fbo));
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_fbo));
 
-    if (!m_setup.useDepthTexture) {
-        m_texture = std::make_unique<Texture>(_width, _height);
-        m_texture->update(0);
-        GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture->getGlHandle(), 0));
+    if (isMultisampled()) {
+        std::vector<GLenum> drawBuffers;
+
+        for (size_t i = 0; i < m_textures.size(); ++i) {
+            GLuint renderBuffer;
+            GL_CHECK(glGenRenderbuffers(1, &renderBuffer));
+            GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, renderBuffer));
+            GL_CHECK(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_setup.samples,
+                m_setup.colorAttachments[i].internalFormat, _width, _height));
+            GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_RENDERBUFFER,
+                renderBuffer));
+
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+            m_colorRenderBuffers.push_back(renderBuffer);
+        }
+
+        GL_CHECK(glDrawBuffers(drawBuffers.size(), drawBuffers.data()));
+        GL_CHECK(glReadBuffer(drawBuffers.empty() ? GL_NONE : GL_COLOR_ATTACHMENT0));
+    } else {
+        createTextures(_width, _height);
     }
 
-    if (m_setup.useDepth) {
-        GLenum renderBufferTarget;
+    // the depth texture is resolved from a multisampled depth render buffer
+    if (m_setup.useDepth || (m_setup.useDepthTexture && isMultisampled())) {
         GL_CHECK(glGenRenderbuffers(1, &m_renderBuffer));
         GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, m_renderBuffer));
-        if (m_setup.useStencil) {
-            renderBufferTarget = GL_DEPTH_STENCIL_ATTACHMENT;
-            GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height));
-        } else {
-            renderBufferTarget = GL_DEPTH_ATTACHMENT;
-            GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32, _width, _height));
-        }
+        storeDepthRenderBuffer(_width, _height);
+
+        GLenum renderBufferTarget = m_setup.useStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
         GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, renderBufferTarget, GL_RENDERBUFFER, m_renderBuffer));
-    } else if (m_setup.useDepthTexture) {
+    }
+
+    checkStatus();
+
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, framebufferBound));
+}
+
+void RenderTarget::createTextures(uint _width, uint _height) {
+    if (!m_setup.useDepthTexture) {
+        GLint maxDrawBuffers = 0;
+        GL_CHECK(glGetIntegerv(GL_MAX_DRAW_BUFFERS, &maxDrawBuffers));
+
+        if (m_setup.colorAttachments.size() > (size_t)maxDrawBuffers) {
+            WARN("Render target has %d color attachments, only %d are supported\n",
+                (int)m_setup.colorAttachments.size(), maxDrawBuffers);
+            m_setup.colorAttachments.resize(maxDrawBuffers);
+        }
+
+        std::vector<GLenum> drawBuffers;
+
+        for (size_t i = 0; i < m_setup.colorAttachments.size(); ++i) {
+            const auto& attachment = m_setup.colorAttachments[i];
+            TextureOptions options;
+
+            options.internalFormat = attachment.internalFormat;
+            options.format = attachment.format;
+            options.type = attachment.type;
+            options.filtering = attachment.filtering;
+
+            auto texture = std::make_unique<Texture>(_width, _height, options);
+            texture->update(0);
+            GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D,
+                texture->getGlHandle(), 0));
+
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+            m_textures.push_back(std::move(texture));
+        }
+
+        // draw buffers are part of the framebuffer state, set them once for all
+        GL_CHECK(glDrawBuffers(drawBuffers.size(), drawBuffers.data()));
+        GL_CHECK(glReadBuffer(drawBuffers.empty() ? GL_NONE : GL_COLOR_ATTACHMENT0));
+    } else {
+        // disable render to color buffer
+        GL_CHECK(glDrawBuffer(GL_NONE));
+        GL_CHECK(glReadBuffer(GL_NONE));
+
         TextureOptions depthTextureOptions;
 
-        depthTextureOptions.internalFormat = GL_DEPTH_COMPONENT32;
+        depthTextureOptions.internalFormat = m_setup.floatDepth ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT32;
         depthTextureOptions.format = GL_DEPTH_COMPONENT;
         depthTextureOptions.type = GL_FLOAT;
         depthTextureOptions.filtering = { GL_NEAREST, GL_NEAREST };
@@ -61,13 +144,82 @@ void RenderTarget::create(uint _width, uint _height) {
         m_depthTexture->update(0);
         GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture->getGlHandle(), 0));
     }
+}
+
+void RenderTarget::storeDepthRenderBuffer(uint _width, uint _height) {
+    // the format matches the depth texture when resolving to it, as required by glBlitFramebuffer
+    GLenum internalFormat = m_setup.useStencil ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT32;
+
+    if (m_setup.floatDepth) {
+        internalFormat = m_setup.useStencil ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F;
+    }
+
+    if (isMultisampled()) {
+        GL_CHECK(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_setup.samples, internalFormat, _width, _height));
+    } else {
+        GL_CHECK(glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, _width, _height));
+    }
+}
+
+void RenderTarget::resizeRenderBuffers(uint _width, uint _height) {
+    for (size_t i = 0; i < m_colorRenderBuffers.size(); ++i) {
+        GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, m_colorRenderBuffers[i]));
+        GL_CHECK(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_setup.samples,
+            m_setup.colorAttachments[i].internalFormat, _width, _height));
+    }
+
+    if (m_renderBuffer) {
+        GL_CHECK(glBindRenderbuffer(GL_RENDERBUFFER, m_renderBuffer));
+        storeDepthRenderBuffer(_width, _height);
+    }
+
+    m_width = _width;
+    m_height = _height;
+}
 
+void RenderTarget::checkStatus() {
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     GL_CHECK(void(0));
     if (GL_FRAMEBUFFER_COMPLETE != status) {
         ERROR("Framebuffer incomplete\n");
         m_isValid = false;
     }
+}
+
+void RenderTarget::resolve() {
+    if (!isMultisampled() || !m_isValid) {
+        return;
+    }
+
+    GLint framebufferBound = 0;
+    GL_CHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebufferBound));
+
+    GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo));
+    GL_CHECK(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolveFbo));
+
+    // a blit only copies from the read buffer, resolve the color attachments one by one
+    for (size_t i = 0; i < m_textures.size(); ++i) {
+        GLenum attachment = GL_COLOR_ATTACHMENT0 + i;
+        GL_CHECK(glReadBuffer(attachment));
+        GL_CHECK(glDrawBuffers(1, &attachment));
+        GL_CHECK(glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    }
+
+    if (m_textures.size() > 1) {
+        std::vector<GLenum> drawBuffers;
+        for (size_t i = 0; i < m_textures.size(); ++i) {
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+        }
+        GL_CHECK(glDrawBuffers(drawBuffers.size(), drawBuffers.data()));
+        GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo));
+        GL_CHECK(glReadBuffer(GL_COLOR_ATTACHMENT0));
+    }
+
+    if (m_depthTexture) {
+        GL_CHECK(glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height,
+            GL_DEPTH_BUFFER_BIT, GL_NEAREST));
+    }
 
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, framebufferBound));
 }
@@ -90,9 +242,19 @@ void RenderTarget::applyDefault(uint _width, uint _height, bool _clear) {
     RenderState::readBuffer(GL_BACK);
 }
 
-void RenderTarget::bindRenderTexture(GLuint _slot) {
-    if (m_texture) {
-        m_texture->bind(_slot);
+const std::unique_ptr<Texture>& RenderTarget::getRenderTexture(uint _index) const {
+    static const std::unique_ptr<Texture> none;
+
+    if (_index >= m_textures.size()) {
+        return none;
+    }
+
+    return m_textures[_index];
+}
+
+void RenderTarget::bindRenderTexture(GLuint _slot, uint _index) {
+    if (_index < m_textures.size()) {
+        m_textures[_index]->bind(_slot);
     } else if (m_depthTexture) {
         m_depthTexture->bind(_slot);
     }
@@ -104,22 +266,41 @@ void RenderTarget::apply(uint _width, uint _height, uint _clearColor) {
         return;
     }
 
-    if (m_texture) {
-        m_texture->resize(_width, _height);
-        m_texture->update(0);
-    } else if (m_depthTexture) {
+    bind(_width, _height);
+    clear(_clearColor);
+}
+
+void RenderTarget::bind(uint _width, uint _height) {
+    if (!m_isValid) {
+        WARN("Invalid render target\n");
+        return;
+    }
+
+    for (auto& texture : m_textures) {
+        texture->resize(_width, _height);
+        texture->update(0);
+    }
+
+    if (m_depthTexture) {
         m_depthTexture->resize(_width, _height);
         m_depthTexture->update(0);
     }
 
+    if (m_width != _width || m_height != _height) {
+        resizeRenderBuffers(_width, _height);
+    }
+
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_fbo));
     GL_CHECK(glViewport(0, 0, _width, _height));
-    GL_CHECK(glDisable(GL_SCISSOR_TEST));
+    RenderState::scissorTest(GL_FALSE);
+}
+
+void RenderTarget::clear(uint _clearColor) {
     GLenum clearBufferBits = GL_COLOR_BUFFER_BIT;
 
+    // the depth clear value is the one of the render state, 0 with a reverse Z projection
     if (m_setup.useDepthTexture || m_setup.useDepth) {
         RenderState::depthWrite(GL_TRUE);
-        GL_CHECK(glClearDepth(1.0));
     }
 
     if (m_setup.useDepth) {
@@ -131,19 +312,16 @@ void RenderTarget::apply(uint _width, uint _height, uint _clearColor) {
     }
 
     if (m_setup.useDepthTexture) {
-        // disable render to color buffer and clear only depth buffer
+        // clear only depth buffer
         clearBufferBits = GL_DEPTH_BUFFER_BIT;
-        RenderState::drawBuffer(GL_NONE);
-        RenderState::readBuffer(GL_NONE);
     } else {
         float r = (_clearColor >> 24) & 0xff;
         float g = (_clearColor >> 16) & 0xff;
         float b = (_clearColor >>  8) & 0xff;
         float a = (_clearColor >>  0) & 0xff;
 
+        // all the color attachments are cleared with the same color
         GL_CHECK(glClearColor(r / 255.0, g / 255.0, b / 255.0, a / 255.0));
-        RenderState::drawBuffer(GL_BACK);
-        RenderState::readBuffer(GL_BACK);
     }
 
     GL_CHECK(glClear(clearBufferBits));
@@ -154,9 +332,17 @@ RenderTarget::~RenderTarget() {
         GL_CHECK(glDeleteFramebuffers(1, &m_fbo));
     }
 
+    if (m_resolveFbo) {
+        GL_CHECK(glDeleteFramebuffers(1, &m_resolveFbo));
+    }
+
     if (m_renderBuffer) {
         GL_CHECK(glDeleteRenderbuffers(1, &m_renderBuffer));
     }
+
+    if (!m_colorRenderBuffers.empty()) {
+        GL_CHECK(glDeleteRenderbuffers(m_colorRenderBuffers.size(), m_colorRenderBuffers.data()));
+    }
 }
 
 } // OGLW
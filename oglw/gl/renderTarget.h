@@ -2,10 +2,30 @@
 
 #include "texture.h"
 #include <memory>
+#include <vector>
 #include "glTypes.h"
 
 namespace OGLW {
 
+struct RenderTargetAttachment {
+    RenderTargetAttachment() {}
+    RenderTargetAttachment(GLenum _internalFormat, GLenum _format, GLenum _type,
+        TextureFiltering _filtering = {}) :
+    internalFormat(_internalFormat), format(_format), type(_type), filtering(_filtering) {}
+    GLenum internalFormat = GL_RGBA8;
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    TextureFiltering filtering;
+
+    bool operator==(const RenderTargetAttachment& _other) const {
+        return internalFormat == _other.internalFormat
+            && format == _other.format
+            && type == _other.type
+            && filtering.min == _other.filtering.min
+            && filtering.mag == _other.filtering.mag;
+    }
+};
+
 struct RenderTargetSetup {
     bool useDepth = false;
 
@@ -14,9 +34,30 @@ struct RenderTargetSetup {
     bool useDepthTexture = false;
     bool useStencil = false;
 
+    // Store the depth as 32 bit floats, together with a reverse Z projection the
+    // precision is spread evenly with the distance to the camera
+    bool floatDepth = false;
+
+    // Color attachments, the fragment shader output at location i writes
+    // to the attachment i, ignored when using the depth texture
+    std::vector<RenderTargetAttachment> colorAttachments = { RenderTargetAttachment() };
+
+    // Number of samples per pixel, a value greater than 1 renders to multisampled
+    // render buffers that have to be resolved before sampling the render textures
+    uint samples = 0;
+
     bool isValid() {
         return !((useDepth || useStencil) && useDepthTexture);
     }
+
+    bool operator==(const RenderTargetSetup& _other) const {
+        return useDepth == _other.useDepth
+            && useDepthTexture == _other.useDepthTexture
+            && useStencil == _other.useStencil
+            && floatDepth == _other.floatDepth
+            && colorAttachments == _other.colorAttachments
+            && samples == _other.samples;
+    }
 };
 
 class RenderTarget {
@@ -29,24 +70,52 @@ public:
     void create(uint _width, uint _height);
     // apply a render target for anything going to be rendered in the viewport
     void apply(uint _width, uint _height, uint _clearColor = 0x0);
-    // get the render target texture
-    const std::unique_ptr<Texture>& getRenderTexture() const { return m_texture; }
+    // bind the render target framebuffer and viewport without clearing its attachments
+    void bind(uint _width, uint _height);
+    // clear the attachments of the render target, the render target should be bound
+    void clear(uint _clearColor = 0x0);
+    // get the render target setup options
+    const RenderTargetSetup& getSetup() const { return m_setup; }
+    // get the render target texture of the color attachment _index
+    const std::unique_ptr<Texture>& getRenderTexture(uint _index = 0) const;
+    // get the number of color attachments of the render target
+    uint getColorAttachmentCount() const { return m_textures.size(); }
     // get the depth render target texture
     const std::unique_ptr<Texture>& getDepthRenderTexture() const { return m_depthTexture; }
     // apply the default render target
     static void applyDefault(uint _width, uint _height, bool _clear = false);
-    // bind the render texture to the specified slot
-    void bindRenderTexture(GLuint _slot);
+    // bind the render texture of the color attachment _index to the specified slot
+    void bindRenderTexture(GLuint _slot, uint _index = 0);
+    // resolve the multisampled attachments to the render textures, no-op for single sampled targets
+    void resolve();
+    // whether the render target renders to multisampled render buffers
+    bool isMultisampled() const { return m_setup.samples > 1; }
 
 private:
-    // the render texture
-    std::unique_ptr<Texture> m_texture;
+    // create the render textures and attach them to the bound framebuffer
+    void createTextures(uint _width, uint _height);
+    // allocate the storage of the bound depth render buffer
+    void storeDepthRenderBuffer(uint _width, uint _height);
+    // reallocate the render buffers storage to a new size
+    void resizeRenderBuffers(uint _width, uint _height);
+    // check the bound framebuffer completeness
+    void checkStatus();
+
+    // the render textures, one per color attachment
+    std::vector<std::unique_ptr<Texture>> m_textures;
     // the render texture
     std::unique_ptr<Texture> m_depthTexture;
     // the GL framebuffer handle
     GLuint m_fbo;
+    // the framebuffer holding the render textures of a multisampled render target
+    GLuint m_resolveFbo;
     // the render buffer depth/stencil
     GLuint m_renderBuffer;
+    // the multisampled color render buffers, one per color attachment
+    std::vector<GLuint> m_colorRenderBuffers;
+    // the size of the render buffers
+    uint m_width;
+    uint m_height;
     // the render target setup options
     RenderTargetSetup m_setup;
     // whether the render target is valid
@@ -100,22 +100,113 @@ bool Shader::add(const std::string& _shaderSource, GLenum _kind, GLuint& _shader
     return true;
 }
 
+std::unique_ptr<Shader> Shader::createDepthOnlyVariant() const {
+    std::string version = "#version 330\n";
+    size_t start = m_vertexSource.find("#version");
+
+    if (start != std::string::npos) {
+        size_t end = m_vertexSource.find('\n', start);
+        version = m_vertexSource.substr(start, end - start) + "\n";
+    }
+
+    // the fragment shader has no output, only the depth buffer is written
+    std::string frag = version + "void main() {}\n";
+
+    auto variant = std::make_unique<Shader>();
+    variant->m_positionInvariant = m_positionInvariant;
+
+    if (!variant->load(frag, m_vertexSource, m_geometrySource)) {
+        WARN("Failed to build depth only shader variant\n");
+    }
+
+    return variant;
+}
+
+bool Shader::makePositionInvariant() {
+    if (m_positionInvariant) {
+        return true;
+    }
+
+    m_positionInvariant = true;
+    GLuint program = m_program;
+
+    if (!load(m_fragmentSource, m_vertexSource, m_geometrySource)) {
+        WARN("Failed to build position invariant shader program\n");
+        m_program = program;
+        m_positionInvariant = false;
+        return false;
+    }
+
+    GL_CHECK(glDeleteProgram(program));
+
+    if (RenderState::shaderProgram.compare(program)) {
+        RenderState::shaderProgram.init(0, false);
+    }
+
+    // locations may differ in the new program
+    m_uniforms.clear();
+
+    return true;
+}
+
+std::string Shader::insertPositionInvariance(const std::string& _src) const {
+    // invariant is only available from glsl 1.20
+    if (_src.find("#version") == std::string::npos) {
+        return _src;
+    }
+
+    // the extension directives must come before any declaration
+    size_t insert = std::string::npos;
+    size_t lineStart = 0;
+
+    while (lineStart < _src.size()) {
+        size_t lineEnd = _src.find('\n', lineStart);
+        size_t directive = _src.find_first_not_of(" \t", lineStart);
+
+        if (lineEnd == std::string::npos) {
+            lineEnd = _src.size();
+        }
+
+        if (directive < lineEnd && (_src.compare(directive, 8, "#version") == 0 ||
+            _src.compare(directive, 10, "#extension") == 0)) {
+            insert = lineEnd;
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    if (insert >= _src.size()) {
+        return _src + "\ninvariant gl_Position;\n";
+    }
+
+    return _src.substr(0, insert + 1) + "invariant gl_Position;\n" + _src.substr(insert + 1);
+}
+
 bool Shader::load(const std::string& _fragmentSrc, const std::string& _vertexSrc, const std::string& _geomSrc) {
     bool addShaders = true;
     GLuint vert = 0, frag = 0, geom = 0;
 
+    m_fragmentSource = _fragmentSrc;
+    m_vertexSource = _vertexSrc;
+    m_geometrySource = _geomSrc;
+
     m_program = glCreateProgram();
     GL_CHECK(void(0));
 
+    // gl_Position is written by the last stage before rasterization
+    bool hasGeometryStage = !_geomSrc.empty();
+
+    bool invariantVertex = m_positionInvariant && !hasGeometryStage;
+
     // add vertex shader to shader program
-    addShaders |= add(_vertexSrc, GL_VERTEX_SHADER, vert);
+    addShaders |= add(invariantVertex ? insertPositionInvariance(_vertexSrc) : _vertexSrc, GL_VERTEX_SHADER, vert);
 
     // add fragment shader to shader program
     addShaders |=  add(_fragmentSrc, GL_FRAGMENT_SHADER, frag);
 
-    if (!_geomSrc.empty()) {
+    if (hasGeometryStage) {
         // add geometry shader to shader program
-        addShaders |= add(_geomSrc, GL_GEOMETRY_SHADER, geom);
+        addShaders |= add(m_positionInvariant ? insertPositionInvariance(_geomSrc) : _geomSrc, GL_GEOMETRY_SHADER, geom);
     }
 
     if (!addShaders) {
@@ -124,6 +215,11 @@ bool Shader::load(const std::string& _fragmentSrc, const std::string& _vertexSrc
         return false;
     }
 
+    // keep the attribute locations bound on a previous program
+    for (const auto& attribute : m_attributes) {
+        GL_CHECK(glBindAttribLocation(m_program, attribute.second, attribute.first.c_str()));
+    }
+
     bool linkStatus = linkShaderProgram(m_program);
 
     GL_CHECK(glDeleteShader(vert));
@@ -138,6 +234,9 @@ bool Shader::load(const std::string& _fragmentSrc, const std::string& _vertexSrc
         return false;
     }
 
+    static uint generation = 0;
+    m_generation = ++generation;
+
     return true;
 }
 
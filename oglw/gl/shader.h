@@ -4,6 +4,7 @@
 #include <iostream>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 #include "gl/gl.h"
 #include "gl/vertexLayout.h"
 #include "uniform.h"
@@ -21,6 +22,18 @@ public:
     // load a bundle shader program
     bool loadBundleSource(const std::string& _bundleSource);
 
+    // create a variant of the shader program writing depth only, the vertex and geometry
+    // stages are kept as is and the fragment stage has no output
+    std::unique_ptr<Shader> createDepthOnlyVariant() const;
+    // rebuild the shader program with gl_Position declared invariant, so that it computes the
+    // same depth as its depth only variant, used by the depth pre-pass
+    bool makePositionInvariant();
+    // whether gl_Position is declared invariant
+    bool isPositionInvariant() const { return m_positionInvariant; }
+    // get a number identifying the GL program built by the last load, never reused by another
+    // program even when the GL reuses the handle
+    uint getGeneration() const { return m_generation; }
+
     // get the GL shader program handle
     GLuint getProgram() const;
     // get the GL fragment shader handle
@@ -63,6 +76,9 @@ private:
     bool load(const std::string& _fragmentSrc, const std::string& _vertexSrc, const std::string& _geomSrc);
     // compile the shader program for the specified type
     bool compile(const std::string& _src, GLenum _type, GLuint& _shader);
+    // declare gl_Position invariant so that programs sharing a vertex stage produce the same depth,
+    // the declaration goes after the #version and #extension directives
+    std::string insertPositionInvariance(const std::string& _src) const;
     // retrieve the uniform location for a given name, lazily access the driver to request for uniform location
     GLint getUniformLocation(const std::string& _uniformName);
 
@@ -73,6 +89,14 @@ private:
     // GL vertex shader id
     GLuint m_vertexShader = -1;
 
+    // sources, kept to derive shader variants and rebuild the program
+    std::string m_fragmentSource;
+    std::string m_vertexSource;
+    std::string m_geometrySource;
+
+    bool m_positionInvariant = false;
+    uint m_generation = 0;
+
     std::unordered_map<std::string, GLuint> m_uniforms;
     std::unordered_map<std::string, GLuint> m_attributes;
 
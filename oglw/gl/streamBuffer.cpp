@@ -0,0 +1,139 @@
+#include "streamBuffer.h"
+#include "core/log.h"
+
+namespace OGLW {
+
+StreamBuffer::StreamBuffer(GLsizeiptr _size, uint _regions) {
+    m_regionSize = _size / _regions;
+    m_size = m_regionSize * _regions;
+    m_fences.resize(_regions, nullptr);
+    m_region = 0;
+    m_head = 0;
+    m_data = nullptr;
+    m_mapped = false;
+    m_persistent = GLEW_ARB_buffer_storage;
+
+    GL_CHECK(glGenBuffers(1, &m_glBuffer));
+
+    // use the copy target not to modify the element array buffer binding of the bound vertex array
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_glBuffer));
+
+    if (m_persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        GL_CHECK(glBufferStorage(GL_COPY_WRITE_BUFFER, m_size, nullptr, flags));
+        m_data = static_cast<GLbyte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_size, flags));
+        GL_CHECK(void(0));
+
+        if (!m_data) {
+            ERROR("Failed to persistently map stream buffer\n");
+        }
+    } else {
+        GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, m_size, nullptr, GL_STREAM_DRAW));
+    }
+
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (GLsync fence : m_fences) {
+        if (fence) {
+            GL_CHECK(glDeleteSync(fence));
+        }
+    }
+
+    if (m_persistent && m_data) {
+        GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_glBuffer));
+        GL_CHECK(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+        GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    }
+
+    GL_CHECK(glDeleteBuffers(1, &m_glBuffer));
+}
+
+void StreamBuffer::nextRegion() {
+    GL_CHECK(m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    m_region = (m_region + 1) % m_fences.size();
+    m_head = m_region * m_regionSize;
+
+    GLsync& fence = m_fences[m_region];
+
+    if (fence) {
+        GLenum status;
+
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            GL_CHECK(void(0));
+        } while (status == GL_TIMEOUT_EXPIRED);
+
+        GL_CHECK(glDeleteSync(fence));
+        fence = nullptr;
+    }
+}
+
+void* StreamBuffer::map(GLsizeiptr _size, GLsizeiptr _alignment, GLintptr& _offset) {
+    if (m_mapped) {
+        WARN("Stream buffer already mapped\n");
+        return nullptr;
+    }
+
+    auto alignUp = [_alignment](GLintptr _value) {
+        return ((_value + _alignment - 1) / _alignment) * _alignment;
+    };
+
+    GLintptr regionStart = m_region * m_regionSize;
+
+    if (alignUp(regionStart) + _size > regionStart + m_regionSize) {
+        WARN("Stream buffer allocation of %d bytes doesn't fit a region of %d bytes\n",
+            (int)_size, (int)m_regionSize);
+        return nullptr;
+    }
+
+    GLintptr start = alignUp(m_head);
+
+    if (start + _size > regionStart + m_regionSize) {
+        nextRegion();
+        start = alignUp(m_head);
+    }
+
+    _offset = start;
+    m_head = start + _size;
+
+    if (m_persistent) {
+        return m_data ? m_data + start : nullptr;
+    }
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_glBuffer));
+    void* data = glMapBufferRange(GL_COPY_WRITE_BUFFER, start, _size, flags);
+    GL_CHECK(void(0));
+
+    m_mapped = data != nullptr;
+
+    return data;
+}
+
+void StreamBuffer::unmap() {
+    if (!m_mapped) {
+        return;
+    }
+
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_glBuffer));
+    GL_CHECK(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+    m_mapped = false;
+}
+
+void StreamBuffer::endFrame() {
+    // nothing was written in the current region, keep it for the next frame
+    if (m_head == (GLintptr)(m_region * m_regionSize)) {
+        return;
+    }
+
+    nextRegion();
+}
+
+} // OGLW
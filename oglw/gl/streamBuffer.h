@@ -0,0 +1,50 @@
+#pragma once
+
+#include "gl/gl.h"
+#include "core/types.h"
+#include <vector>
+
+namespace OGLW {
+
+// A ring buffer for dynamic geometry written by the CPU every frame. The buffer is split
+// in regions, each frame writes in its own region with a bump pointer and a fence is placed
+// when leaving the region, so that a region is only rewritten once the GPU is done with it.
+// With ARB_buffer_storage the whole buffer is persistently mapped, otherwise each allocation
+// is mapped unsynchronized and the fences still protect the regions in flight.
+class StreamBuffer {
+public:
+    StreamBuffer(GLsizeiptr _size, uint _regions = 3);
+    ~StreamBuffer();
+
+    // reserve _size bytes with the start offset aligned on _alignment and return a pointer to write
+    // them to, _offset is the byte offset of the allocation in the buffer, nullptr if it can't fit a region
+    void* map(GLsizeiptr _size, GLsizeiptr _alignment, GLintptr& _offset);
+    // make the data written since the last map available to the GPU
+    void unmap();
+    // fence the region written this frame and move to the next one, should be called once the
+    // draw calls sourcing the frame data have been issued
+    void endFrame();
+    // get the GL buffer handle
+    GLuint getGlHandle() const { return m_glBuffer; }
+    // whether the buffer is persistently mapped
+    bool isPersistent() const { return m_persistent; }
+
+private:
+    // fence the current region and wait for the next one to be released by the GPU
+    void nextRegion();
+
+    GLuint m_glBuffer;
+    GLsizeiptr m_size;
+    GLsizeiptr m_regionSize;
+    // the persistently mapped buffer memory
+    GLbyte* m_data;
+    // a fence per region, null when the region is not in use by the GPU
+    std::vector<GLsync> m_fences;
+    uint m_region;
+    // the write offset in the buffer
+    GLintptr m_head;
+    bool m_persistent;
+    bool m_mapped;
+};
+
+} // OGLW
@@ -7,6 +7,51 @@
 
 namespace OGLW {
 
+// size in bytes of a pixel for a given format and type
+static size_t bytesPerPixel(GLenum _format, GLenum _type) {
+    switch (_type) {
+    case GL_UNSIGNED_INT_24_8:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+    case GL_UNSIGNED_INT_5_9_9_9_REV:
+        return 4;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+        return 8;
+    }
+
+    size_t components = 4;
+
+    switch (_format) {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+        components = 1;
+        break;
+    case GL_RG:
+    case GL_RG_INTEGER:
+        components = 2;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+        components = 3;
+        break;
+    }
+
+    switch (_type) {
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        return components * 2;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+        return components * 4;
+    default:
+        return components;
+    }
+}
+
 Texture::Texture(uint _width, uint _height, TextureOptions _options, bool _generateMipmaps) :
 m_options(_options),
 m_generateMipmaps(_generateMipmaps)
@@ -100,10 +145,12 @@ void Texture::update(GLuint _textureUnit) {
 
         generate(_textureUnit);
 
-        // if no data make sure texture is 0-filled at creation (useful for transform lookup)
+        // if no data make sure texture is 0-filled at creation (useful for transform lookup),
+        // rows are aligned on 4 bytes as expected by the default unpack alignment
         if (m_data.size() == 0) {
-            m_data.resize(m_width * m_height);
-            std::memset(m_data.data(), 0, m_data.size());
+            size_t rowBytes = (m_width * bytesPerPixel(m_options.format, m_options.type) + 3) & ~3;
+            m_data.resize(rowBytes * m_height / sizeof(GLuint));
+            std::memset(m_data.data(), 0, m_data.size() * sizeof(GLuint));
         }
     } else {
 
@@ -1,9 +1,20 @@
 #include "vboMesh.h"
 #include "gl/gl.h"
+#include "gl/vertexConversion.h"
+#include "gl/geometryPool.h"
+#include "gl/occlusionQuery.h"
+#include "core/meshOptimizer.h"
+#include "core/meshSimplifier.h"
+#include "core/camera.h"
+#include "core/mappedFile.h"
 #include "core/log.h"
+#include <limits>
 
 namespace OGLW {
 
+// queries of a mesh waiting for their results, no more are issued until they are available
+static const size_t maxPendingQueries = 3;
+
 VboMesh::VboMesh(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode, GLenum _hint) : VboMesh() {
     m_vertexLayout = _vertexLayout;
     m_hint = _hint;
@@ -17,12 +28,36 @@ VboMesh::VboMesh() {
     m_nIndices = 0;
     m_isUploaded = false;
     m_isCompiled = false;
+    m_isConverted = false;
     m_dirtyOffset = 0;
     m_dirtySize = 0;
     m_dirty = false;
+    m_indexType = GL_UNSIGNED_INT;
+    m_splitIndices = false;
+    m_optimize = false;
+    m_lodLevels = 0;
+    m_lodRatio = 0.5f;
+    m_pooled = true;
+    m_boundsDirty = false;
+    m_poolHandle = GeometryPool::invalidHandle;
+    m_occlusionQueryMode = OcclusionQueryMode::conditional;
+    m_conditionalQuery = 0;
+    m_occluded = false;
 }
 
 VboMesh::~VboMesh() {
+    if (m_pool) {
+        m_pool->release(m_poolHandle);
+    }
+
+    if (m_conditionalQuery) {
+        OcclusionQuery::release(m_conditionalQuery);
+    }
+
+    for (GLuint query : m_pendingQueries) {
+        OcclusionQuery::release(query);
+    }
+
     if (m_glVertexBuffer) {
         GL_CHECK(glDeleteBuffers(1, &m_glVertexBuffer));
     }
@@ -36,6 +71,216 @@ void VboMesh::setVertexLayout(std::shared_ptr<VertexLayout> _vertexLayout) {
     m_vertexLayout = _vertexLayout;
 }
 
+void VboMesh::setCompressedLayout(std::shared_ptr<VertexLayout> _compressedLayout) {
+    if (m_isCompiled) {
+        WARN("The compressed layout should be set before compiling the mesh\n");
+        return;
+    }
+
+    m_compressedLayout = _compressedLayout;
+}
+
+void VboMesh::optimizeMeshData(std::vector<GLuint>& _indices) {
+    if (m_drawMode != GL_TRIANGLES || m_hint != GL_STATIC_DRAW || _indices.empty()) {
+        WARN("Only static indexed triangle meshes can be optimized\n");
+        return;
+    }
+
+    size_t stride = m_vertexLayout->getStride();
+    const VertexAttrib* position = m_vertexLayout->getAttribute("position");
+    bool sortClusters = position && position->type == GL_FLOAT;
+    float acmr = computeACMR(_indices, m_nVertices);
+
+    std::vector<Submesh> submeshes = m_submeshes;
+
+    if (submeshes.empty()) {
+        submeshes.push_back({ 0, GLuint(m_nVertices), 0, GLuint(_indices.size()) });
+    }
+
+    // submeshes are optimized independently, their indices must stay in their vertex range
+    for (const auto& submesh : submeshes) {
+        for (GLuint i = submesh.indexOffset; i < submesh.indexOffset + submesh.indexCount; ++i) {
+            if (_indices[i] < submesh.vertexOffset || _indices[i] >= submesh.vertexOffset + submesh.vertexCount) {
+                WARN("Submesh indices out of its vertex range, skipping mesh optimization\n");
+                return;
+            }
+        }
+    }
+
+    GLuint nVertices = 0;
+
+    for (auto& submesh : submeshes) {
+        auto first = _indices.begin() + submesh.indexOffset;
+        std::vector<GLuint> indices(first, first + submesh.indexCount);
+        GLbyte* vertices = m_glVertexData + submesh.vertexOffset * stride;
+
+        for (auto& index : indices) {
+            index -= submesh.vertexOffset;
+        }
+
+        std::vector<size_t> clusters;
+        size_t nSubmeshVertices = weldVertices(vertices, submesh.vertexCount, stride, indices);
+
+        optimizeVertexCache(indices, nSubmeshVertices, 16, &clusters);
+
+        if (sortClusters) {
+            optimizeOverdraw(indices, clusters, vertices, stride, (size_t)position->offset, position->size);
+        }
+
+        nSubmeshVertices = optimizeVertexFetch(vertices, nSubmeshVertices, stride, indices);
+
+        // pack the submesh vertices right after the previous submesh ones
+        std::memmove(m_glVertexData + nVertices * stride, vertices, nSubmeshVertices * stride);
+
+        for (size_t i = 0; i < indices.size(); ++i) {
+            *(first + i) = indices[i] + nVertices;
+        }
+
+        submesh.vertexOffset = nVertices;
+        submesh.vertexCount = nSubmeshVertices;
+        nVertices += nSubmeshVertices;
+    }
+
+    INFO("Optimized mesh from %d to %d vertices, ACMR from %.3f to %.3f\n",
+        m_nVertices, nVertices, acmr, computeACMR(_indices, nVertices));
+
+    if (!m_submeshes.empty()) {
+        m_submeshes = submeshes;
+    }
+
+    m_nVertices = nVertices;
+}
+
+void VboMesh::setLodLevels(uint _levels, float _ratio) {
+    if (m_isCompiled) {
+        WARN("The levels of detail should be set before compiling the mesh\n");
+        return;
+    }
+
+    m_lodLevels = _levels;
+    m_lodRatio = glm::clamp(_ratio, 0.0f, 1.0f);
+}
+
+void VboMesh::computeBounds() const {
+    const VertexAttrib* position = m_vertexLayout->getAttribute("position");
+
+    m_boundsDirty = false;
+
+    if (!position || position->type != GL_FLOAT || m_nVertices == 0 || !m_glVertexData) {
+        return;
+    }
+
+    size_t stride = m_vertexLayout->getStride();
+    const GLbyte* positions = m_glVertexData + (size_t)position->offset;
+
+    m_bounds = OGLW::computeBounds(positions, m_nVertices, stride, position->size);
+
+    for (auto& submesh : m_submeshes) {
+        submesh.bounds = OGLW::computeBounds(positions + submesh.vertexOffset * stride, submesh.vertexCount,
+            stride, position->size);
+    }
+}
+
+const Bounds& VboMesh::getBounds() const {
+    if (m_boundsDirty) {
+        computeBounds();
+    }
+
+    return m_bounds;
+}
+
+const Bounds& VboMesh::getSubmeshBounds(uint _submesh) const {
+    if (m_boundsDirty) {
+        computeBounds();
+    }
+
+    return m_submeshes[_submesh].bounds;
+}
+
+void VboMesh::generateLods(std::vector<GLuint>& _indices) {
+    const VertexAttrib* position = m_vertexLayout->getAttribute("position");
+
+    if (m_drawMode != GL_TRIANGLES || _indices.empty() || !position || position->type != GL_FLOAT) {
+        WARN("Levels of detail are only generated for indexed triangle meshes with float positions\n");
+        return;
+    }
+
+    size_t stride = m_vertexLayout->getStride();
+
+    m_lods.clear();
+    m_lods.push_back({ 0, GLuint(_indices.size()), 0.0f });
+
+    std::vector<GLuint> source(_indices);
+    std::vector<GLuint> simplified;
+
+    // each level is simplified from the previous one, their errors add up
+    for (uint level = 0; level < m_lodLevels; ++level) {
+        size_t target = size_t(source.size() / 3 * m_lodRatio) * 3;
+        float error = simplifyMesh(source, m_glVertexData, m_nVertices, stride, (size_t)position->offset,
+            position->size, target, std::numeric_limits<float>::max(), simplified);
+
+        // the locked borders and seams prevent further simplification
+        if (simplified.empty() || simplified.size() > source.size() * 0.95f) {
+            WARN("Level of detail chain truncated at %d of %d levels, the borders and seams of the mesh "
+                "can't be simplified further\n", int(level), int(m_lodLevels));
+            break;
+        }
+
+        optimizeVertexCache(simplified, m_nVertices);
+
+        m_lods.push_back({ GLuint(_indices.size()), GLuint(simplified.size()), m_lods.back().error + error });
+        _indices.insert(_indices.end(), simplified.begin(), simplified.end());
+        source.swap(simplified);
+    }
+
+    INFO("Generated %d levels of detail, down to %d triangles\n", int(m_lods.size() - 1), int(source.size() / 3));
+
+    m_nIndices = _indices.size();
+}
+
+uint VboMesh::selectLod(const Camera& _camera, const glm::mat4& _model, float _viewportHeight,
+    float _pixelError) const
+{
+    if (m_lods.size() < 2) {
+        return 0;
+    }
+
+    float scale = std::max(glm::length(glm::vec3(_model[0])),
+        std::max(glm::length(glm::vec3(_model[1])), glm::length(glm::vec3(_model[2]))));
+    Bounds bounds = getBounds().transform(_model);
+
+    // distance to the closest point of the bounding sphere
+    float distance = glm::length(bounds.center - _camera.getPosition()) - bounds.radius;
+    distance = std::max(distance, _camera.getNear());
+
+    // size in pixels of a unit length at a unit distance
+    float pixelsPerUnit = 0.5f * _viewportHeight * _camera.getProjectionMatrix()[1][1];
+    uint lod = 0;
+
+    for (uint i = 1; i < m_lods.size(); ++i) {
+        if (m_lods[i].error * scale / distance * pixelsPerUnit > _pixelError) {
+            break;
+        }
+        lod = i;
+    }
+
+    return lod;
+}
+
+void VboMesh::convertVertexData() {
+    std::vector<GLbyte> data(m_nVertices * m_compressedLayout->getStride());
+
+    if (!convertVertices(*m_vertexLayout, m_glVertexData, *m_compressedLayout, data.data(), m_nVertices)) {
+        WARN("Failed to convert the mesh vertices, keeping the source layout\n");
+        return;
+    }
+
+    m_vertexStorage.swap(data);
+    m_glVertexData = m_vertexStorage.data();
+    m_vertexLayout = m_compressedLayout;
+    m_isConverted = true;
+}
+
 void VboMesh::setDrawMode(GLenum _drawMode) {
     switch (_drawMode) {
     case GL_POINTS:
@@ -57,34 +302,57 @@ bool VboMesh::upload() {
         return false;
     }
 
-    // Create vertex Buffer if needed
-    if (m_glVertexBuffer == 0) {
-        GL_CHECK(glGenBuffers(1, &m_glVertexBuffer));
-    }
-
     if (!m_isCompiled) {
         compileVertexBuffer();
     }
 
     int vertexBytes = m_nVertices * m_vertexLayout->getStride();
+    GLsizeiptr indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    GLsizeiptr indexBytes = m_glIndexData ? m_nIndices * indexSize : 0;
 
-    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glVertexBuffer));
-    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertexBytes, m_glVertexData, m_hint));
+    if (m_pooled && m_hint == GL_STATIC_DRAW) {
+        // static meshes are suballocated in the shared buffers of their layout
+        m_pool = GeometryPool::get(m_vertexLayout);
+        m_poolHandle = m_pool->allocate(m_nVertices, indexBytes);
+        m_pool->uploadVertices(m_poolHandle, m_glVertexData, 0, vertexBytes);
 
-    if (m_glIndexData) {
-        if (m_glIndexBuffer == 0) {
-            GL_CHECK(glGenBuffers(1, &m_glIndexBuffer));
+        if (m_glIndexData) {
+            m_pool->uploadIndices(m_poolHandle, m_glIndexData, indexBytes);
+        }
+    } else {
+        // Create vertex Buffer if needed
+        if (m_glVertexBuffer == 0) {
+            GL_CHECK(glGenBuffers(1, &m_glVertexBuffer));
         }
 
-        GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glIndexBuffer));
-        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_nIndices * sizeof(GLuint), m_glIndexData, GL_STATIC_DRAW));
+        GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glVertexBuffer));
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertexBytes, m_glVertexData, m_hint));
+
+        if (m_glIndexData) {
+            if (m_glIndexBuffer == 0) {
+                GL_CHECK(glGenBuffers(1, &m_glIndexBuffer));
+            }
+
+            GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glIndexBuffer));
+            GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, m_glIndexData, GL_STATIC_DRAW));
+        }
+    }
+
+    m_glIndexData = nullptr;
+    std::vector<GLbyte>().swap(m_indexStorage);
+
+    // dynamic meshes keep their vertices to be updated
+    bool keepVertices = m_hint != GL_STATIC_DRAW;
 
-        delete[] m_glIndexData;
-        m_glIndexData = nullptr;
+    if (!keepVertices) {
+        m_glVertexData = nullptr;
+        std::vector<GLbyte>().swap(m_vertexStorage);
+        m_mappedFile.reset();
     }
 
-    delete[] m_glVertexData;
-    m_glVertexData = nullptr;
+    // the arena isn't needed anymore when the uploaded vertices were converted or remapped
+    releaseData(keepVertices && m_vertexStorage.empty());
+
     m_isUploaded = true;
 
     return true;
@@ -99,6 +367,19 @@ bool VboMesh::subDataUpload() {
         WARN("wrong usage hint provided to the Vbo\n");
     }
 
+    // the pool buffers are shared, only the modified range is uploaded
+    if (m_pool) {
+        if (m_glVertexData) {
+            m_pool->uploadVertices(m_poolHandle, m_glVertexData + m_dirtyOffset, m_dirtyOffset, m_dirtySize);
+        }
+
+        m_dirtyOffset = 0;
+        m_dirtySize = 0;
+        m_dirty = false;
+
+        return true;
+    }
+
     GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glVertexBuffer));
 
     long vertexBytes = m_nVertices * m_vertexLayout->getStride();
@@ -131,12 +412,121 @@ bool VboMesh::subDataUpload() {
 }
 
 void VboMesh::draw(Shader& _shader) {
+    draw(_shader, 0);
+}
+
+void VboMesh::draw(Shader& _shader, uint _lod) {
+    Vao& vao = prepareDraw(_shader);
+    submitDraw(_lod, 0);
+    vao.unbind();
+}
+
+void VboMesh::drawInstanced(Shader& _shader, InstanceVbo& _instances, uint _lod) {
+    if (_instances.numInstances() == 0) {
+        return;
+    }
+
+    VertexLayout& instanceLayout = *_instances.getVertexLayout();
+    const auto& locations = instanceLayout.getLocations();
+
+    _shader.bindVertexLayout(instanceLayout);
+    Vao& vao = prepareDraw(_shader);
+
+    // the instance attributes source the instance buffer while bound to the mesh vertex array,
+    // they are disabled after the draw so that the vertex array can be drawn without instances
+    _instances.bind();
+    instanceLayout.enable(locations);
+
+    submitDraw(_lod, _instances.numInstances());
+
+    instanceLayout.disable(locations);
+    vao.unbind();
+}
+
+void VboMesh::drawOcclusionCulled(Shader& _shader, const glm::mat4& _modelViewProjection, uint _lod) {
+    const Bounds& bounds = getBounds();
+
+    // the camera is inside or close to the box, the mesh is visible, meshes without float
+    // positions have no bounds to query
+    if (bounds.min == bounds.max || OcclusionQuery::crossesNearPlane(bounds.min, bounds.max, _modelViewProjection)) {
+        m_occluded = false;
+        draw(_shader, _lod);
+        return;
+    }
+
+    GLenum target = OcclusionQuery::target();
+
+    if (m_occlusionQueryMode == OcclusionQueryMode::conditional) {
+        if (!m_conditionalQuery) {
+            m_conditionalQuery = OcclusionQuery::acquire();
+        }
+
+        GL_CHECK(glBeginQuery(target, m_conditionalQuery));
+        OcclusionQuery::drawProxy(bounds.min, bounds.max, _modelViewProjection);
+        GL_CHECK(glEndQuery(target));
+
+        // the query was just issued, waiting lets the GPU hold the draw until its result is known
+        // instead of drawing anyway, the CPU doesn't wait
+        GL_CHECK(glBeginConditionalRender(m_conditionalQuery, GL_QUERY_WAIT));
+        draw(_shader, _lod);
+        GL_CHECK(glEndConditionalRender());
+        return;
+    }
+
+    // results become available in the order the queries were issued, read the ones ready
+    while (!m_pendingQueries.empty()) {
+        GLuint query = m_pendingQueries.front();
+        GLuint available = GL_FALSE;
+        GL_CHECK(glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available));
+
+        if (!available) {
+            break;
+        }
+
+        GLuint samplesPassed = 0;
+        GL_CHECK(glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samplesPassed));
+
+        m_occluded = samplesPassed == 0;
+        m_pendingQueries.pop_front();
+        OcclusionQuery::release(query);
+    }
+
+    GLuint query = 0;
+
+    if (m_pendingQueries.size() < maxPendingQueries) {
+        query = OcclusionQuery::acquire();
+        GL_CHECK(glBeginQuery(target, query));
+    }
+
+    if (!m_occluded) {
+        draw(_shader, _lod);
+    } else if (query) {
+        OcclusionQuery::drawProxy(bounds.min, bounds.max, _modelViewProjection);
+    }
+
+    if (query) {
+        GL_CHECK(glEndQuery(target));
+        m_pendingQueries.push_back(query);
+    }
+}
+
+Vao& VboMesh::prepareDraw(Shader& _shader) {
     if (!m_isUploaded) {
         upload();
     } else if (m_dirty) {
         subDataUpload();
     }
 
+    _shader.bindVertexLayout(*m_vertexLayout);
+    _shader.use();
+
+    // pooled meshes share the vertex array of the pool
+    if (m_pool) {
+        Vao& vao = m_pool->getVao();
+        vao.bind();
+        return vao;
+    }
+
     // if VAO not yet created, initialized it and capture related states
     if (!m_vao) {
         m_vao = std::unique_ptr<Vao>(new Vao());
@@ -145,34 +535,204 @@ void VboMesh::draw(Shader& _shader) {
         m_vao->init(m_glVertexBuffer, m_glIndexBuffer, *m_vertexLayout, locations);
     }
 
-    _shader.bindVertexLayout(*m_vertexLayout);
-    _shader.use();
-
     m_vao->bind();
 
-    if (m_nIndices > 0) {
-        GL_CHECK(glDrawElements(m_drawMode, m_nIndices, GL_UNSIGNED_INT, NULL));
+    return *m_vao;
+}
+
+void VboMesh::submitDraw(uint _lod, GLsizei _instances) {
+    if (!m_lods.empty()) {
+        _lod = std::min<uint>(_lod, m_lods.size() - 1);
+    }
+
+    // the ranges of a pooled mesh are offset in the pool buffers
+    GLintptr indexBase = 0;
+    GLint vertexBase = 0;
+
+    if (m_pool) {
+        const auto& range = m_pool->getRange(m_poolHandle);
+        indexBase = range.indexByteOffset;
+        vertexBase = range.vertexOffset;
+    }
+
+    auto drawElements = [&](GLsizei _count, GLintptr _byteOffset, GLint _baseVertex) {
+        GLvoid* offset = (GLvoid*)(indexBase + _byteOffset);
+
+        if (_instances > 0) {
+            GL_CHECK(glDrawElementsInstancedBaseVertex(m_drawMode, _count, m_indexType, offset, _instances,
+                vertexBase + _baseVertex));
+        } else {
+            GL_CHECK(glDrawElementsBaseVertex(m_drawMode, _count, m_indexType, offset, vertexBase + _baseVertex));
+        }
+    };
+
+    if (!m_indexChunks.empty()) {
+        for (const auto& chunk : m_indexChunks) {
+            if (chunk.lod == _lod) {
+                drawElements(chunk.count, chunk.byteOffset, chunk.baseVertex);
+            }
+        }
+    } else if (m_nIndices > 0) {
+        GLintptr indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+        if (m_lods.empty()) {
+            drawElements(m_nIndices, 0, 0);
+        } else {
+            drawElements(m_lods[_lod].indexCount, m_lods[_lod].indexOffset * indexSize, 0);
+        }
     } else if (m_nVertices > 0) {
-        GL_CHECK(glDrawArrays(m_drawMode, 0, m_nVertices));
+        if (_instances > 0) {
+            GL_CHECK(glDrawArraysInstanced(m_drawMode, vertexBase, m_nVertices, _instances));
+        } else {
+            GL_CHECK(glDrawArrays(m_drawMode, vertexBase, m_nVertices));
+        }
+    }
+}
+
+void VboMesh::compileIndices(const std::vector<GLuint>& _indices) {
+    const GLuint maxShortVertices = std::numeric_limits<GLushort>::max() + 1;
+
+    m_indexChunks.clear();
+
+    if ((GLuint)m_nVertices <= maxShortVertices) {
+        m_indexStorage.resize(_indices.size() * sizeof(GLushort));
+        GLushort* indices = reinterpret_cast<GLushort*>(m_indexStorage.data());
+
+        for (size_t i = 0; i < _indices.size(); ++i) {
+            indices[i] = _indices[i];
+        }
+
+        m_indexType = GL_UNSIGNED_SHORT;
+        m_glIndexData = m_indexStorage.data();
+        return;
     }
 
-    m_vao->unbind();
+    if (m_splitIndices) {
+        if (m_drawMode != GL_TRIANGLES) {
+            WARN("Only triangle meshes can be split in 16 bit index chunks\n");
+        } else if (m_hint != GL_STATIC_DRAW) {
+            WARN("Splitting indices reorders the vertices, only static meshes can be split\n");
+        } else {
+            splitIndices(_indices);
+            return;
+        }
+    }
+
+    m_indexType = GL_UNSIGNED_INT;
+    m_glIndexData = reinterpret_cast<const GLbyte*>(_indices.data());
 }
 
-std::vector<glm::vec3> VboMesh::computeNormals(std::vector<glm::vec3> _vertices, std::vector<int> _indices) {
-    std::vector<glm::vec3> normals;
-    normals.resize(_vertices.size());
+void VboMesh::splitIndices(const std::vector<GLuint>& _indices) {
+    const int maxChunkVertices = std::numeric_limits<GLushort>::max() + 1;
+    int stride = m_vertexLayout->getStride();
+
+    std::vector<GLbyte> vertexData;
+    std::vector<GLushort> indices;
+    // position of a vertex in the current chunk, -1 if not yet added to it
+    std::vector<int> remap(m_nVertices, -1);
+    std::vector<GLuint> chunkVertices;
+    int baseVertex = 0;
+    size_t chunkStart = 0;
+    uint lod = 0;
+
+    vertexData.reserve(m_nVertices * stride);
+    indices.reserve(_indices.size());
+
+    auto closeChunk = [&]() {
+        if (chunkVertices.empty()) {
+            return;
+        }
+
+        m_indexChunks.push_back({
+            GLintptr(chunkStart * sizeof(GLushort)),
+            GLsizei(indices.size() - chunkStart),
+            baseVertex,
+            lod
+        });
 
-    for (uint i = 0; i < _indices.size() / 3; ++i) {
-        int i1 = _indices[3 * i + 0];
-        int i2 = _indices[3 * i + 1];
-        int i3 = _indices[3 * i + 2];
+        for (GLuint vertex : chunkVertices) {
+            remap[vertex] = -1;
+        }
+
+        baseVertex += chunkVertices.size();
+        chunkStart = indices.size();
+        chunkVertices.clear();
+    };
+
+    // greedily add triangles to the current chunk until its vertices can't be addressed with 16 bits
+    for (size_t i = 0; i + 2 < _indices.size(); i += 3) {
+        const GLuint* triangle = &_indices[i];
+        int newVertices = 0;
+
+        // levels of detail get their own chunks, the vertices they share with the previous levels are duplicated
+        if (lod + 1 < m_lods.size() && i == m_lods[lod + 1].indexOffset) {
+            closeChunk();
+            lod++;
+        }
+
+        for (int j = 0; j < 3; ++j) {
+            bool duplicate = (j > 0 && triangle[j] == triangle[0]) || (j > 1 && triangle[j] == triangle[1]);
+            if (remap[triangle[j]] < 0 && !duplicate) {
+                newVertices++;
+            }
+        }
+
+        if ((int)chunkVertices.size() + newVertices > maxChunkVertices) {
+            closeChunk();
+        }
+
+        for (int j = 0; j < 3; ++j) {
+            GLuint vertex = triangle[j];
+
+            if (remap[vertex] < 0) {
+                remap[vertex] = chunkVertices.size();
+                chunkVertices.push_back(vertex);
+                vertexData.insert(vertexData.end(), m_glVertexData + vertex * stride,
+                    m_glVertexData + (vertex + 1) * stride);
+            }
+
+            indices.push_back(remap[vertex]);
+        }
+    }
+
+    closeChunk();
+
+    m_vertexStorage.swap(vertexData);
+    m_glVertexData = m_vertexStorage.data();
+    m_nVertices = baseVertex;
+
+    m_indexStorage.resize(indices.size() * sizeof(GLushort));
+    std::memcpy(m_indexStorage.data(), indices.data(), m_indexStorage.size());
+    m_glIndexData = m_indexStorage.data();
+
+    m_nIndices = indices.size();
+    m_indexType = GL_UNSIGNED_SHORT;
+}
+
+std::vector<glm::vec3> VboMesh::computeNormals(const std::vector<glm::vec3>& _vertices,
+    const std::vector<int>& _indices)
+{
+    std::vector<glm::vec3> normals(_vertices.size());
+
+    for (size_t i = 0; i + 2 < _indices.size(); i += 3) {
+        int i1 = _indices[i + 0];
+        int i2 = _indices[i + 1];
+        int i3 = _indices[i + 2];
 
         const glm::vec3& v1 = _vertices[i1];
         const glm::vec3& v2 = _vertices[i2];
         const glm::vec3& v3 = _vertices[i3];
 
-        glm::vec3 d = glm::normalize(glm::cross(v2 - v1, v3 - v1));
+        glm::vec3 d = glm::cross(v2 - v1, v3 - v1);
+        float length = glm::length(d);
+
+        // degenerate faces have no direction
+        if (length == 0.f) {
+            continue;
+        }
+
+        // each face contributes its unit normal, whatever its size or shape
+        d /= length;
 
         normals[i1] += d;
         normals[i2] += d;
@@ -180,10 +740,14 @@ std::vector<glm::vec3> VboMesh::computeNormals(std::vector<glm::vec3> _vertices,
     }
 
     for (auto& n : normals) {
-        n = glm::normalize(n);
+        float length = glm::length(n);
+
+        if (length > 0.f) {
+            n /= length;
+        }
     }
 
-    return std::move(normals);
+    return normals;
 }
 
 } // OGLW
@@ -3,100 +3,233 @@
 #include <vector>
 #include <memory>
 #include <cstring>
+#include <deque>
 #include <unordered_map>
 #include "gl/glTypes.h"
 #include "gl/vertexLayout.h"
 #include "gl/shader.h"
 #include "gl/vao.h"
+#include "gl/instanceBuffer.h"
+#include "gl/geometryPool.h"
+#include "glm/glm.hpp"
+#include "core/bounds.h"
 
 namespace OGLW {
 
+class Camera;
+class MappedFile;
+
 class VboMesh {
 
 public:
+    // a batch of vertices and indices added to the mesh, ranges are in the mesh arena
+    struct Submesh {
+        GLuint vertexOffset;
+        GLuint vertexCount;
+        GLuint indexOffset;
+        GLuint indexCount;
+        // bounds of the vertices of the batch
+        Bounds bounds;
+    };
+
+    // a level of detail, a range of the index buffer drawing a simplified version of the whole mesh
+    struct Lod {
+        GLuint indexOffset;
+        GLuint indexCount;
+        // bound of the distance between the simplified and the full surfaces, in model space
+        float error;
+    };
+
+    // how drawOcclusionCulled uses occlusion queries
+    enum class OcclusionQueryMode {
+        // the bounding box is queried before each draw, which is rendered conditionally on the
+        // query result by the gpu, the draw goes ahead when the result isn't ready in time
+        conditional,
+        // the draw is skipped when the last available query result found the mesh occluded,
+        // visible meshes are queried with their own draw and occluded ones with their bounding box
+        previousFrame,
+    };
+
     VboMesh(std::shared_ptr<VertexLayout> _vertexlayout, GLenum _drawMode = GL_TRIANGLES, GLenum _hint = GL_STATIC_DRAW);
     VboMesh();
     virtual ~VboMesh();
 
     void setVertexLayout(std::shared_ptr<VertexLayout> _vertexLayout);
+    // get the layout of the vertices added to the mesh
+    std::shared_ptr<VertexLayout> getVertexLayout() const { return m_vertexLayout; }
+    // convert the vertices to a compressed layout when compiling, attributes are matched by name,
+    // the vertices of a converted mesh can't be updated
+    void setCompressedLayout(std::shared_ptr<VertexLayout> _compressedLayout);
     void setDrawMode(GLenum _drawMode = GL_TRIANGLES);
 
     // number of vertices in the mesh
     int numVertices() const { return m_nVertices; }
     // number of indices in the mesh
     int numIndices() const { return m_nIndices; }
+    // get the batches of vertices and indices the mesh was built from
+    const std::vector<Submesh>& getSubmeshes() const { return m_submeshes; }
+    // get the bounds of the mesh positions, computed when compiling and again after the vertices were updated
+    const Bounds& getBounds() const;
+    // get the bounds of the positions of a batch of vertices
+    const Bounds& getSubmeshBounds(uint _submesh) const;
+    // type of the compiled indices, GL_UNSIGNED_SHORT when the vertex count allows it
+    GLenum getIndexType() const { return m_indexType; }
+    // split triangle meshes with too many vertices for 16 bit indices into 16 bit addressable chunks,
+    // the vertices shared by chunks are duplicated, only used for static meshes
+    void setSplitIndices(bool _split) { m_splitIndices = _split; }
+    // weld duplicate vertices and reorder triangles and vertices of each submesh for the vertex cache,
+    // overdraw and vertex fetch when compiling, only used for static triangle meshes
+    void setOptimize(bool _optimize) { m_optimize = _optimize; }
+    // suballocate the vertices and indices of a static mesh in the geometry pool of its layout instead of
+    // its own buffers, the meshes of a pool share a vertex array, enabled by default
+    void setPooled(bool _pooled) { m_pooled = _pooled; }
+    // get the geometry pool the mesh is allocated in, null until uploaded or when not pooled
+    std::shared_ptr<GeometryPool> getGeometryPool() const { return m_pool; }
+    // generate up to _levels simplified levels of detail when compiling, each keeping _ratio of the
+    // triangles of the previous one, the levels share the vertices of the full mesh
+    void setLodLevels(uint _levels, float _ratio = 0.5f);
+    // get the levels of detail, the first one is the full mesh
+    const std::vector<Lod>& getLods() const { return m_lods; }
+    // select the coarsest level of detail whose error projects to at most _pixelError pixels on a viewport
+    // of _viewportHeight pixels, for the mesh drawn with _model
+    uint selectLod(const Camera& _camera, const glm::mat4& _model, float _viewportHeight,
+        float _pixelError = 1.0f) const;
     // compile the vertex buffer to unsigned byte data for ready for upload
     virtual void compileVertexBuffer() = 0;
     // draw the mesh for a specific shader program
     void draw(Shader& _shader);
-    // compute normals for a set of vertices and indices
-    static std::vector<glm::vec3> computeNormals(std::vector<glm::vec3> _vertices, std::vector<int> _indices);
+    // draw a level of detail of the mesh for a specific shader program
+    void draw(Shader& _shader, uint _lod);
+    // draw a level of detail of the mesh once per instance of _instances in a single draw call,
+    // the instance attributes are bound to the locations of the instance buffer layout
+    void drawInstanced(Shader& _shader, InstanceVbo& _instances, uint _lod = 0);
+    // set how drawOcclusionCulled uses occlusion queries, conditional by default
+    void setOcclusionQueryMode(OcclusionQueryMode _mode) { m_occlusionQueryMode = _mode; }
+    // draw a level of detail of the mesh unless its bounding box transformed by _modelViewProjection
+    // is occluded by the previous draws, the queries never block, the query state is kept per mesh
+    // so the mesh is expected to be drawn this way once per frame
+    void drawOcclusionCulled(Shader& _shader, const glm::mat4& _modelViewProjection, uint _lod = 0);
+    // whether the last available query found the mesh occluded, in the previousFrame mode
+    bool isOccluded() const { return m_occluded; }
+    // compute normals for a set of vertices and indices, each face adds its unit normal to its vertices,
+    // see core/geometryProcessing.h for area or angle weighted normals over larger meshes
+    static std::vector<glm::vec3> computeNormals(const std::vector<glm::vec3>& _vertices,
+        const std::vector<int>& _indices);
     // get the buffer dirty size (data not yet uploaded in gpu)
     GLsizei getDirtySize() const { return m_dirtySize; }
     // get the buffer dirty offset (memory location offset not yet uploaded starts)
     GLintptr getDirtyOffset() const { return m_dirtyOffset; }
 
 protected:
+    friend class MeshCache;
+
     bool upload();
     bool subDataUpload();
+    // upload the mesh if needed, bind the vertex layout and the shader, and bind the vertex array
+    Vao& prepareDraw(Shader& _shader);
+    // issue the draw calls of a level of detail, instanced when _instances isn't 0
+    void submitDraw(uint _lod, GLsizei _instances);
+    // run the optimization passes on the compiled vertex data and _indices
+    void optimizeMeshData(std::vector<GLuint>& _indices);
+    // compute the bounds of the mesh and of its batches from the float positions of the compiled vertices
+    void computeBounds() const;
+    // append the indices of the simplified levels of detail to _indices
+    void generateLods(std::vector<GLuint>& _indices);
+    // convert the compiled vertex data to the compressed layout
+    void convertVertexData();
+    // select the index type, 32 bit indices are uploaded from _indices without copy
+    void compileIndices(const std::vector<GLuint>& _indices);
+    // split the indices in chunks of at most 65536 vertices, remapping the vertex buffer
+    void splitIndices(const std::vector<GLuint>& _indices);
+
+    // a range of the index buffer drawn with its own base vertex
+    struct IndexChunk {
+        GLintptr byteOffset;
+        GLsizei count;
+        GLint baseVertex;
+        // level of detail the chunk belongs to
+        uint lod;
+    };
 
     std::shared_ptr<VertexLayout> m_vertexLayout;
+    std::shared_ptr<VertexLayout> m_compressedLayout;
 
     int m_nVertices;
     GLuint m_glVertexBuffer;
+    // the compiled vertices, points into the mesh arena or to m_vertexStorage
     GLbyte* m_glVertexData = nullptr;
+    // vertices converted or remapped when compiling
+    std::vector<GLbyte> m_vertexStorage;
+    // the mesh cache the compiled vertices and indices were read from
+    std::unique_ptr<MappedFile> m_mappedFile;
     std::unique_ptr<Vao> m_vao;
+    // the shared buffers a static mesh is allocated in and its ranges in them
+    std::shared_ptr<GeometryPool> m_pool;
+    GeometryPool::Handle m_poolHandle;
+    bool m_pooled;
 
     int m_nIndices;
     GLuint m_glIndexBuffer;
-    GLuint* m_glIndexData = nullptr;
+    // the compiled indices, points into the mesh arena or to m_indexStorage
+    const GLbyte* m_glIndexData = nullptr;
+    // indices narrowed to 16 bits when compiling
+    std::vector<GLbyte> m_indexStorage;
+    GLenum m_indexType;
+    bool m_splitIndices;
+    bool m_optimize;
+    std::vector<IndexChunk> m_indexChunks;
+    // mutable to refresh their bounds lazily
+    mutable std::vector<Submesh> m_submeshes;
+    std::vector<Lod> m_lods;
+    uint m_lodLevels;
+    float m_lodRatio;
+    // bounds of the positions, computed when compiling and lazily after vertex updates
+    mutable Bounds m_bounds;
+    mutable bool m_boundsDirty;
     GLenum m_hint;
     GLenum m_drawMode;
 
+    OcclusionQueryMode m_occlusionQueryMode;
+    // the query the conditional draws depend on
+    GLuint m_conditionalQuery;
+    // queries issued in the previous frames whose results haven't been read yet, oldest first
+    std::deque<GLuint> m_pendingQueries;
+    bool m_occluded;
+
     bool m_isUploaded;
     bool m_isCompiled;
+    bool m_isConverted;
     bool m_dirty;
 
     GLsizei m_dirtySize;
     GLintptr m_dirtyOffset;
 
-    template <typename T>
-    void compile(std::vector<std::vector<T>>& _vertices, std::vector<std::vector<int>>& _indices) {
-
-        std::vector<std::vector<T>> vertices;
-        std::vector<std::vector<int>> indices;
+    // free the cpu copy of the mesh data once uploaded, _keepVertices is set when the
+    // vertices stored in the mesh arena are still needed to update a dynamic mesh
+    virtual void releaseData(bool _keepVertices) {}
 
-        // take over contents
-        std::swap(_vertices, vertices);
-        std::swap(_indices, indices);
-
-        // Buffer positions: vertex byte and index short
-        int vPos = 0, iPos = 0;
-        int vertexOffset = 0;
-
-        int stride = m_vertexLayout->getStride();
-        m_glVertexData = new GLbyte[stride * m_nVertices];
+    template <typename T>
+    void compile(std::vector<T>& _vertices, std::vector<GLuint>& _indices) {
+        // the vertex arena is uploaded as is
+        m_glVertexData = reinterpret_cast<GLbyte*>(_vertices.data());
 
-        bool useIndices = m_nIndices > 0;
-        if (useIndices) {
-            m_glIndexData = new GLuint[m_nIndices];
+        if (m_optimize) {
+            optimizeMeshData(_indices);
         }
 
-        for (size_t i = 0; i < vertices.size(); i++) {
-            auto curVertices = vertices[i];
-            size_t nVertices = curVertices.size();
-            int nBytes = nVertices * stride;
+        // the submeshes vertex ranges are final once optimized, the positions are still floats
+        computeBounds();
 
-            std::memcpy(m_glVertexData + vPos, (GLbyte*)curVertices.data(), nBytes);
-            vPos += nBytes;
+        if (m_lodLevels > 0) {
+            generateLods(_indices);
+        }
 
-            if (useIndices) {
-                for (int idx : indices[i]) {
-                    m_glIndexData[iPos++] = idx + vertexOffset;
-                }
-            }
+        if (m_compressedLayout) {
+            convertVertexData();
+        }
 
-            vertexOffset += nVertices;
+        if (m_nIndices > 0) {
+            compileIndices(_indices);
         }
 
         m_isCompiled = true;
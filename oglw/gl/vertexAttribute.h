@@ -9,7 +9,13 @@ enum AttributeLocation : char {
     position = 0,
     uv,
     color,
-    normal
+    normal,
+    // tangent in xyz and the bitangent sign in w
+    tangent,
+    // first location of the per instance attributes
+    instance,
+    // index of the draw in a batch of draws, the last location guaranteed by GL
+    drawId = 15
 };
 
 struct VertexAttrib {
@@ -19,6 +25,9 @@ struct VertexAttrib {
     GLboolean normalized;
     GLvoid* offset;
     GLuint location;
+    // advance the attribute once every divisor instances instead of once per vertex, 0 for vertex data,
+    // attributes of more than 4 components span consecutive locations, e.g. a mat4 takes 4 locations
+    GLuint divisor = 0;
 };
 
 } // OGLW
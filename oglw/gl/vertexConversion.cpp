@@ -0,0 +1,133 @@
+#include "vertexConversion.h"
+#include "gl/gl.h"
+#include "core/log.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace OGLW {
+
+template <class T>
+static void writeComponents(GLbyte* _dst, const glm::vec4& _value, GLint _size, T (*_pack)(float)) {
+    for (GLint i = 0; i < _size; ++i) {
+        T component = _pack(_value[i]);
+        std::memcpy(_dst + i * sizeof(T), &component, sizeof(T));
+    }
+}
+
+template <class T>
+static T cast(float _value) {
+    return static_cast<T>(std::round(_value));
+}
+
+static float identity(float _value) {
+    return _value;
+}
+
+static GLushort packHalf(float _value) {
+    return glm::packHalf1x16(_value);
+}
+
+static GLbyte packSnormByte(float _value) {
+    return glm::packSnorm1x8(_value);
+}
+
+static GLubyte packUnormByte(float _value) {
+    return glm::packUnorm1x8(_value);
+}
+
+static GLshort packSnormShort(float _value) {
+    return glm::packSnorm1x16(_value);
+}
+
+static GLushort packUnormShort(float _value) {
+    return glm::packUnorm1x16(_value);
+}
+
+static bool writeAttribute(const VertexAttrib& _attrib, const glm::vec4& _value, GLbyte* _dst) {
+    bool normalized = _attrib.normalized;
+
+    switch (_attrib.type) {
+    case GL_FLOAT:
+        writeComponents<GLfloat>(_dst, _value, _attrib.size, identity);
+        return true;
+    case GL_HALF_FLOAT:
+        writeComponents<GLushort>(_dst, _value, _attrib.size, packHalf);
+        return true;
+    case GL_BYTE:
+        writeComponents<GLbyte>(_dst, _value, _attrib.size, normalized ? packSnormByte : cast<GLbyte>);
+        return true;
+    case GL_UNSIGNED_BYTE:
+        writeComponents<GLubyte>(_dst, _value, _attrib.size, normalized ? packUnormByte : cast<GLubyte>);
+        return true;
+    case GL_SHORT:
+        writeComponents<GLshort>(_dst, _value, _attrib.size, normalized ? packSnormShort : cast<GLshort>);
+        return true;
+    case GL_UNSIGNED_SHORT:
+        writeComponents<GLushort>(_dst, _value, _attrib.size, normalized ? packUnormShort : cast<GLushort>);
+        return true;
+    case GL_INT:
+        writeComponents<GLint>(_dst, _value, _attrib.size, cast<GLint>);
+        return true;
+    case GL_UNSIGNED_INT:
+        writeComponents<GLuint>(_dst, _value, _attrib.size, cast<GLuint>);
+        return true;
+    case GL_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV: {
+        if (!normalized) {
+            break;
+        }
+        GLuint packed = _attrib.type == GL_INT_2_10_10_10_REV
+            ? glm::packSnorm3x10_1x2(_value)
+            : glm::packUnorm3x10_1x2(_value);
+        std::memcpy(_dst, &packed, sizeof(GLuint));
+        return true;
+    }
+    default:
+        break;
+    }
+
+    return false;
+}
+
+bool convertVertices(const VertexLayout& _srcLayout, const GLbyte* _srcData,
+    const VertexLayout& _dstLayout, GLbyte* _dstData, size_t _nVertices)
+{
+    GLint srcStride = _srcLayout.getStride();
+    GLint dstStride = _dstLayout.getStride();
+
+    for (const auto& dstAttrib : _dstLayout.getAttributes()) {
+        const VertexAttrib* srcAttrib = _srcLayout.getAttribute(dstAttrib.name);
+        size_t srcOffset = 0;
+        size_t dstOffset = reinterpret_cast<size_t>(dstAttrib.offset);
+        GLint nComponents = 0;
+
+        if (srcAttrib) {
+            if (srcAttrib->type != GL_FLOAT) {
+                WARN("Vertex attribute %s can only be converted from floats\n", dstAttrib.name.c_str());
+                return false;
+            }
+            srcOffset = reinterpret_cast<size_t>(srcAttrib->offset);
+            nComponents = std::min(srcAttrib->size, 4);
+        }
+
+        for (size_t v = 0; v < _nVertices; ++v) {
+            glm::vec4 value(0.0, 0.0, 0.0, 1.0);
+
+            for (GLint i = 0; i < nComponents; ++i) {
+                std::memcpy(&value[i], _srcData + v * srcStride + srcOffset + i * sizeof(float), sizeof(float));
+            }
+
+            if (!writeAttribute(dstAttrib, value, _dstData + v * dstStride + dstOffset)) {
+                WARN("Vertex attribute %s can't be converted to its type\n", dstAttrib.name.c_str());
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+} // OGLW
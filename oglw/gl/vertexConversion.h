@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include "gl/glTypes.h"
+#include "gl/vertexLayout.h"
+
+namespace OGLW {
+
+// Converts _nVertices vertices laid out as _srcLayout to _dstLayout, attributes are matched
+// by name. Source attributes must be GL_FLOAT, destination attributes can be any float, integer,
+// half float or packed 2_10_10_10 type, normalized integer types are quantized to their range.
+// Destination attributes missing from the source are set to (0, 0, 0, 1), source attributes
+// missing from the destination are dropped. Returns false if an attribute can't be converted.
+bool convertVertices(const VertexLayout& _srcLayout, const GLbyte* _srcData,
+    const VertexLayout& _dstLayout, GLbyte* _dstData, size_t _nVertices);
+
+} // OGLW
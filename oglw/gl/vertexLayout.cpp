@@ -2,6 +2,7 @@
 #include "core/types.h"
 #include "gl/shader.h"
 #include "core/log.h"
+#include <algorithm>
 
 namespace OGLW {
 
@@ -11,22 +12,43 @@ VertexLayout::VertexLayout(std::vector<VertexAttrib> _attribs) : m_attribs(_attr
     for (uint i = 0; i < m_attribs.size(); i++) {
         m_attribs[i].offset = reinterpret_cast<void*>(m_stride);
 
-        GLint byteSize = m_attribs[i].size;
-
-        switch (m_attribs[i].type) {
-        case GL_FLOAT:
-        case GL_INT:
-        case GL_UNSIGNED_INT:
-            byteSize *= 4;
-            break;
-        case GL_SHORT:
-        case GL_UNSIGNED_SHORT:
-            byteSize *= 2;
-            break;
-        }
+        m_stride += getAttributeByteSize(m_attribs[i]);
+    }
+}
+
+GLint VertexLayout::getAttributeByteSize(const VertexAttrib& _attrib) {
+    switch (_attrib.type) {
+    case GL_DOUBLE:
+        return _attrib.size * 8;
+    case GL_FLOAT:
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+        return _attrib.size * 4;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        return _attrib.size * 2;
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return _attrib.size;
+    case GL_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        return 4;
+    default:
+        WARN("Unknown vertex attribute type for attribute %s\n", _attrib.name.c_str());
+        return _attrib.size;
+    }
+}
 
-        m_stride += byteSize;
+const VertexAttrib* VertexLayout::getAttribute(const std::string& _name) const {
+    for (const auto& attrib : m_attribs) {
+        if (attrib.name == _name) {
+            return &attrib;
+        }
     }
+
+    return nullptr;
 }
 
 VertexLayout::~VertexLayout() {
@@ -59,14 +81,20 @@ void VertexLayout::enable(const std::unordered_map<std::string, GLuint>& _locati
 
         const GLint location = it->second;
 
-        void* data = _ptr ? _ptr : ((uchar*) attrib.offset) + _byteOffset;
-        GL_CHECK(glEnableVertexAttribArray(location));
-        GL_CHECK(glVertexAttribPointer(location,
-                    attrib.size,
-                    attrib.type,
-                    attrib.normalized,
-                    m_stride,
-                    data));
+        uchar* data = _ptr ? (uchar*) _ptr : ((uchar*) attrib.offset) + _byteOffset;
+        GLint columnSize = getAttributeByteSize(attrib) * 4 / std::max(attrib.size, 4);
+
+        // matrices are split in columns of at most 4 components on consecutive locations
+        for (GLint column = 0; column * 4 < attrib.size; ++column) {
+            GL_CHECK(glEnableVertexAttribArray(location + column));
+            GL_CHECK(glVertexAttribPointer(location + column,
+                        std::min(attrib.size - column * 4, 4),
+                        attrib.type,
+                        attrib.normalized,
+                        m_stride,
+                        data + column * columnSize));
+            GL_CHECK(glVertexAttribDivisor(location + column, attrib.divisor));
+        }
     }
 }
 
@@ -77,8 +105,15 @@ void VertexLayout::disable(const std::unordered_map<std::string, GLuint>& _locat
         if (it == _locations.end()) {
             continue;
         }
+
         const GLint location = it->second;
-        GL_CHECK(glDisableVertexAttribArray(location));
+
+        for (GLint column = 0; column * 4 < attrib.size; ++column) {
+            GL_CHECK(glDisableVertexAttribArray(location + column));
+            if (attrib.divisor != 0) {
+                GL_CHECK(glVertexAttribDivisor(location + column, 0));
+            }
+        }
     }
 }
 
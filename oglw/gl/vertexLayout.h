@@ -22,9 +22,13 @@ public:
     // get the stride of the vertex layout in bytes
     GLint getStride() const { return m_stride; };
     // get the vertex attributes of the vertex layout
-    const std::vector<VertexAttrib>& getAttributes() { return m_attribs; };
+    const std::vector<VertexAttrib>& getAttributes() const { return m_attribs; };
     // get the vertex layout locations
     std::unordered_map<std::string, GLuint> getLocations() const;
+    // get a vertex attribute by name, nullptr if the layout doesn't have it
+    const VertexAttrib* getAttribute(const std::string& _name) const;
+    // get the size in bytes of a vertex attribute, packed types hold all their components in 4 bytes
+    static GLint getAttributeByteSize(const VertexAttrib& _attrib);
 
 private:
     std::vector<VertexAttrib> m_attribs;
@@ -59,7 +59,7 @@ void oglwDrawDebugProjectedText(std::string _text,
 {
     LAZY_INIT
 
-    glm::mat4 vpMatrix = _camera.getProjectionMatrix() * _camera.getViewMatrix();
+    const glm::mat4& vpMatrix = _camera.getViewProjectionMatrix();
     dd::projectedText(_text, &_pos[0], &_color[0], glm::value_ptr(vpMatrix), _viewportSize[0], _viewportSize[1],
             _viewportSize[2], _viewportSize[3], _scaling);
 }
@@ -116,7 +116,7 @@ void oglwDrawDebugAABB(glm::vec3 _mins, glm::vec3 _maxs, OGLW::rgb _color) {
 void oglwDrawDebugCameraFrustum(const Camera& _camera, OGLW::rgb _color) {
     LAZY_INIT
 
-    glm::mat4 invClipMatrix = glm::inverse(_camera.getProjectionMatrix() * _camera.getViewMatrix());
+    const glm::mat4& invClipMatrix = _camera.getInverseViewProjectionMatrix();
     dd::frustum(glm::value_ptr(invClipMatrix), &_color[0]);
 }
 
@@ -146,7 +146,7 @@ void oglwDrawDebugXZSquareGrid(float _mins, float _maxs, float _y, float _step,
 void oglwDrawDebugFlush(const Camera& _camera) {
     LAZY_INIT
 
-    m_debugRenderer->setMVP(_camera.getProjectionMatrix() * _camera.getViewMatrix());
+    m_debugRenderer->setMVP(_camera.getViewProjectionMatrix());
 
     dd::flush(0.f);
 }
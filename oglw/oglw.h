@@ -11,7 +11,13 @@
 #include "shader.h"
 #include "tiny_obj_loader.h"
 #include "mesh.h"
+#include "instanceBuffer.h"
+#include "occlusionQuery.h"
 #include "camera.h"
+#include "transformHierarchy.h"
+#include "culling.h"
+#include "bvh.h"
+#include "occlusion.h"
 #include "texture.h"
 #include "geometries.h"
 #include "renderState.h"
@@ -21,6 +27,7 @@
 // other
 #include "app.h"
 #include "utils.h"
+#include "jobSystem.h"
 
 // renderer
 #include "debugRenderer.h"
@@ -28,6 +35,9 @@
 #include "quadRenderer.h"
 #include "skyboxRenderer.h"
 #include "guiRenderer.h"
+#include "frameGraph.h"
+#include "depthPrepass.h"
+#include "meshBatch.h"
 
 // gamma
 #ifdef OGLW_GAMMA
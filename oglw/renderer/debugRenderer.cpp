@@ -5,6 +5,8 @@
 #include "gl/vertexLayout.h"
 #include "gl/vao.h"
 #include "gl/texture.h"
+#include "gl/streamBuffer.h"
+#include <cstring>
 #include "core/log.h"
 
 #define DEBUG_DRAW_IMPLEMENTATION
@@ -38,6 +40,8 @@ void DebugRenderer::init() {
         #pragma end:fragment
     )END";
 
+    m_streamBuffer = std::make_unique<StreamBuffer>(3 * 1024 * 1024);
+
     m_lineMesh.shader = std::make_unique<Shader>();
     m_lineMesh.shader->loadBundleSource(lineShaderBundle);
     m_lineMesh.layout = std::unique_ptr<VertexLayout>(new VertexLayout({
@@ -46,10 +50,7 @@ void DebugRenderer::init() {
     }));
 
     m_lineMesh.vao = std::make_unique<Vao>();
-
-    // TODO: glDeleteBuffers
-    GL_CHECK(glGenBuffers(1, &m_lineMesh.vertexBuffer));
-    m_lineMesh.vao->init(m_lineMesh.vertexBuffer, 0, *m_lineMesh.layout, m_lineMesh.layout->getLocations());
+    m_lineMesh.vao->init(m_streamBuffer->getGlHandle(), 0, *m_lineMesh.layout, m_lineMesh.layout->getLocations());
     m_lineMesh.shader->bindVertexLayout(*m_lineMesh.layout);
 
     static const std::string textShaderBundle = R"END(
@@ -90,8 +91,7 @@ void DebugRenderer::init() {
     }));
 
     m_textMesh.vao = std::make_unique<Vao>();
-    GL_CHECK(glGenBuffers(1, &m_textMesh.vertexBuffer));
-    m_textMesh.vao->init(m_textMesh.vertexBuffer, 0, *m_textMesh.layout, m_textMesh.layout->getLocations());
+    m_textMesh.vao->init(m_streamBuffer->getGlHandle(), 0, *m_textMesh.layout, m_textMesh.layout->getLocations());
     m_textMesh.shader->bindVertexLayout(*m_textMesh.layout);
 
     dd::initialize(this);
@@ -105,6 +105,24 @@ void DebugRenderer::beginDraw() {
 
 void DebugRenderer::endDraw() {
     RenderState::pop();
+    m_streamBuffer->endFrame();
+}
+
+void DebugRenderer::streamVertices(const dd::DrawVertex* _vertices, int _count, GLenum _drawMode) {
+    GLsizeiptr size = _count * sizeof(dd::DrawVertex);
+    GLintptr offset;
+
+    // align on the vertex size so that the offset can be expressed as a first vertex
+    void* data = m_streamBuffer->map(size, sizeof(dd::DrawVertex), offset);
+
+    if (!data) {
+        return;
+    }
+
+    std::memcpy(data, _vertices, size);
+    m_streamBuffer->unmap();
+
+    GL_CHECK(glDrawArrays(_drawMode, offset / sizeof(dd::DrawVertex), _count));
 }
 
 void DebugRenderer::drawPointList(const dd::DrawVertex* _points,
@@ -121,12 +139,7 @@ void DebugRenderer::drawLineList(const dd::DrawVertex* _lines,
     m_lineMesh.shader->setUniform("mvp", m_mvp);
     m_lineMesh.vao->bind();
 
-    // buffer orphaning
-    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_lineMesh.vertexBuffer));
-    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, _count * sizeof(dd::DrawVertex), NULL, GL_DYNAMIC_DRAW));
-    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, _count * sizeof(dd::DrawVertex), _lines, GL_DYNAMIC_DRAW));
-
-    GL_CHECK(glDrawArrays(GL_LINES, 0, _count));
+    streamVertices(_lines, _count, GL_LINES);
 
     m_lineMesh.vao->unbind();
 }
@@ -143,14 +156,7 @@ void DebugRenderer::drawGlyphList(const dd::DrawVertex* _glyphs,
     RenderState::blending(GL_TRUE);
     RenderState::blendingFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // buffer orphaning
-    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_textMesh.vertexBuffer));
-
-    // TODO: use glMapBuffer instead
-    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, _count * sizeof(dd::DrawVertex), NULL, GL_DYNAMIC_DRAW));
-    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, _count * sizeof(dd::DrawVertex), _glyphs, GL_DYNAMIC_DRAW));
-
-    GL_CHECK(glDrawArrays(GL_TRIANGLES, 0, _count));
+    streamVertices(_glyphs, _count, GL_TRIANGLES);
 
     m_textMesh.vao->unbind();
 }
@@ -174,8 +180,6 @@ void DebugRenderer::destroyGlyphTexture(dd::GlyphTextureHandle _glyphTex) {
     m_textMesh.texture.reset();
 }
 
-DebugRenderer::~DebugRenderer() {
-    glDeleteBuffers(1, &m_textMesh.vertexBuffer);
-}
+DebugRenderer::~DebugRenderer() {}
 
 } // OGLW
@@ -12,6 +12,7 @@ class Shader;
 class VertexLayout;
 class Texture;
 class Vao;
+class StreamBuffer;
 
 class DebugRenderer : public dd::RenderInterface {
 public:
@@ -29,9 +30,10 @@ public:
     void setMVP(glm::mat4 _mvp) { m_mvp = _mvp; }
 
 private:
+    // write the vertices to the stream buffer and draw them with the bound vertex array
+    void streamVertices(const dd::DrawVertex* _vertices, int _count, GLenum _drawMode);
 
     struct Mesh {
-        GLuint vertexBuffer;
         std::unique_ptr<Texture> texture;
         std::unique_ptr<Shader> shader;
         std::unique_ptr<VertexLayout> layout;
@@ -41,6 +43,8 @@ private:
     Mesh m_lineMesh;
     Mesh m_textMesh;
 
+    // the vertices of both meshes are streamed in the same buffer
+    std::unique_ptr<StreamBuffer> m_streamBuffer;
     GLint m_boundBuffer;
     glm::mat4 m_mvp;
 };
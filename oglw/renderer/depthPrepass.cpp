@@ -0,0 +1,65 @@
+#include "depthPrepass.h"
+#include "gl/renderState.h"
+#include "core/log.h"
+
+namespace OGLW {
+
+Shader& DepthPrepass::getDepthShader(Shader& _shader) {
+    // without invariance the depth and shading programs may compute different depths for the
+    // same vertices and the shading phase would miss fragments
+    _shader.makePositionInvariant();
+
+    uint64_t key = (uint64_t(_shader.getProgram()) << 32) | _shader.getGeneration();
+    auto& depthShader = m_depthShaders[key];
+
+    if (!depthShader) {
+        depthShader = _shader.createDepthOnlyVariant();
+    }
+
+    return *depthShader;
+}
+
+void DepthPrepass::beginDepth() {
+    if (m_phase != Phase::none) {
+        WARN("Depth pre-pass already started\n");
+        return;
+    }
+
+    // under reverse Z the depth is cleared to 0 and nearer fragments have a greater depth
+    GLenum func = RenderState::depthFunc.get<0>();
+    bool reverseZ = func == GL_GREATER || func == GL_GEQUAL;
+
+    RenderState::push();
+
+    RenderState::depthTest(GL_TRUE);
+    RenderState::depthWrite(GL_TRUE);
+    RenderState::depthFunc(reverseZ ? GL_GREATER : GL_LESS);
+    RenderState::colorWrite(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    m_phase = Phase::depth;
+}
+
+void DepthPrepass::beginShading() {
+    if (m_phase != Phase::depth) {
+        WARN("Depth pre-pass shading phase started without a depth phase\n");
+        return;
+    }
+
+    RenderState::colorWrite(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    RenderState::depthWrite(GL_FALSE);
+    RenderState::depthFunc(GL_EQUAL);
+
+    m_phase = Phase::shading;
+}
+
+void DepthPrepass::end() {
+    if (m_phase == Phase::none) {
+        return;
+    }
+
+    RenderState::pop();
+
+    m_phase = Phase::none;
+}
+
+} // OGLW
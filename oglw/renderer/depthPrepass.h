@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "gl/shader.h"
+
+namespace OGLW {
+
+// Renders the opaque geometry in two phases: the depth phase lays down the depth buffer
+// with depth only shader variants, the shading phase then runs the full shader programs
+// only on the visible fragments, by testing for depth equality without writing depth
+class DepthPrepass {
+public:
+    DepthPrepass() : m_phase(Phase::none) {}
+    ~DepthPrepass() {}
+
+    // get the depth only variant of a shader program, created on first use, the shader program
+    // is rebuilt with an invariant gl_Position to produce the same depth as its variant
+    Shader& getDepthShader(Shader& _shader);
+    // start the depth phase, color writes are disabled, the depth comparison follows the depth
+    // function in use, as set by Camera::applyDepthState() for reverse Z projections
+    void beginDepth();
+    // start the shading phase, only fragments matching the depth buffer are shaded
+    void beginShading();
+    // restore the render states saved when starting the depth phase
+    void end();
+
+private:
+    enum class Phase { none, depth, shading };
+
+    // depth only variants keyed by program handle and generation, a shader destroyed and another
+    // one built at the same address or with the same handle can't get a stale variant
+    std::unordered_map<uint64_t, std::unique_ptr<Shader>> m_depthShaders;
+    Phase m_phase;
+};
+
+} // OGLW
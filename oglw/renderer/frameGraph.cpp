@@ -0,0 +1,443 @@
+#include "frameGraph.h"
+#include "core/log.h"
+#include <algorithm>
+
+namespace OGLW {
+
+FrameGraphResource FrameGraphPassBuilder::create(const std::string& _name, FrameGraphTargetDesc _desc) {
+    FrameGraph::Resource resource;
+
+    resource.name = _name;
+    resource.desc = _desc;
+    resource.imported = false;
+    resource.firstUse = -1;
+    resource.lastUse = -1;
+    resource.physical = -1;
+    resource.refCount = 0;
+
+    if (!resource.desc.setup.isValid()) {
+        WARN("Invalid render target setup for frame graph resource %s\n", _name.c_str());
+    }
+
+    m_graph.m_resources.push_back(resource);
+
+    return m_graph.m_resources.size() - 1;
+}
+
+FrameGraphResource FrameGraphPassBuilder::read(FrameGraphResource _resource) {
+    if (_resource < 0 || _resource >= (int)m_graph.m_resources.size()) {
+        WARN("Reading invalid frame graph resource %d\n", _resource);
+        return _resource;
+    }
+
+    m_graph.m_resources[_resource].readers.push_back(m_pass);
+    m_graph.m_passes[m_pass].reads.push_back(_resource);
+
+    return _resource;
+}
+
+FrameGraphResource FrameGraphPassBuilder::write(FrameGraphResource _resource, bool _clear, uint _clearColor) {
+    if (_resource < 0 || _resource >= (int)m_graph.m_resources.size()) {
+        WARN("Writing invalid frame graph resource %d\n", _resource);
+        return _resource;
+    }
+
+    auto& pass = m_graph.m_passes[m_pass];
+
+    if (!pass.writes.empty()) {
+        WARN("Pass %s writes to more than one render target\n", pass.name.c_str());
+    }
+
+    m_graph.m_resources[_resource].writers.push_back(m_pass);
+    pass.writes.push_back({_resource, _clear, _clearColor});
+
+    return _resource;
+}
+
+void FrameGraphPassBuilder::setSideEffect() {
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+FrameGraph::FrameGraph() {
+    reset();
+}
+
+FrameGraph::~FrameGraph() {}
+
+void FrameGraph::reset() {
+    m_passes.clear();
+    m_resources.clear();
+    m_order.clear();
+    m_compiled = false;
+    m_valid = false;
+
+    Resource backbuffer;
+    backbuffer.name = "backbuffer";
+    backbuffer.imported = true;
+    backbuffer.firstUse = -1;
+    backbuffer.lastUse = -1;
+    backbuffer.physical = -1;
+    backbuffer.refCount = 0;
+
+    m_resources.push_back(backbuffer);
+    m_backbuffer = 0;
+}
+
+void FrameGraph::addPass(const std::string& _name, SetupFn _setup, ExecuteFn _execute) {
+    Pass pass;
+
+    pass.name = _name;
+    pass.execute = _execute;
+    pass.sideEffect = false;
+    pass.culled = false;
+    pass.refCount = 0;
+
+    m_passes.push_back(pass);
+    m_compiled = false;
+
+    FrameGraphPassBuilder builder(*this, m_passes.size() - 1);
+    _setup(builder);
+}
+
+void FrameGraph::cull() {
+    std::vector<FrameGraphResource> unreferenced;
+
+    for (auto& pass : m_passes) {
+        pass.culled = false;
+        pass.refCount = pass.writes.size();
+
+        // passes rendering to the default framebuffer are the roots of the graph
+        for (const auto& write : pass.writes) {
+            if (m_resources[write.resource].imported) {
+                pass.sideEffect = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_resources.size(); ++i) {
+        auto& resource = m_resources[i];
+        resource.refCount = resource.readers.size();
+
+        if (!resource.imported && resource.refCount == 0) {
+            unreferenced.push_back(i);
+        }
+    }
+
+    // a pass whose outputs are never read is culled, which in turn releases the resources it reads
+    while (!unreferenced.empty()) {
+        FrameGraphResource resource = unreferenced.back();
+        unreferenced.pop_back();
+
+        for (int writer : m_resources[resource].writers) {
+            auto& pass = m_passes[writer];
+
+            if (--pass.refCount > 0 || pass.sideEffect || pass.culled) {
+                continue;
+            }
+
+            pass.culled = true;
+
+            for (FrameGraphResource read : pass.reads) {
+                auto& readResource = m_resources[read];
+                if (--readResource.refCount == 0 && !readResource.imported) {
+                    unreferenced.push_back(read);
+                }
+            }
+        }
+    }
+}
+
+void FrameGraph::sort() {
+    size_t nPasses = m_passes.size();
+    std::vector<std::vector<int>> edges(nPasses);
+    std::vector<int> inDegree(nPasses, 0);
+
+    auto addEdge = [&](int _from, int _to) {
+        if (m_passes[_from].culled || _from == _to) {
+            return;
+        }
+        edges[_from].push_back(_to);
+        inDegree[_to]++;
+    };
+
+    // declaration order defines the dependencies between passes touching the same resource
+    for (size_t i = 0; i < nPasses; ++i) {
+        const auto& pass = m_passes[i];
+
+        if (pass.culled) {
+            continue;
+        }
+
+        for (FrameGraphResource read : pass.reads) {
+            for (int writer : m_resources[read].writers) {
+                if (writer < (int)i) { addEdge(writer, i); }
+            }
+        }
+
+        for (const auto& write : pass.writes) {
+            for (int writer : m_resources[write.resource].writers) {
+                if (writer < (int)i) { addEdge(writer, i); }
+            }
+            for (int reader : m_resources[write.resource].readers) {
+                if (reader < (int)i) { addEdge(reader, i); }
+            }
+        }
+    }
+
+    std::vector<int> ready;
+    for (size_t i = 0; i < nPasses; ++i) {
+        if (!m_passes[i].culled && inDegree[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    m_order.clear();
+    FrameGraphResource bound = -1;
+
+    while (!ready.empty()) {
+        // prefer a pass rendering to the currently bound target to save a framebuffer switch,
+        // fallback to declaration order
+        auto next = ready.end();
+
+        for (auto it = ready.begin(); it != ready.end(); ++it) {
+            const auto& writes = m_passes[*it].writes;
+            if (!writes.empty() && writes[0].resource == bound && (next == ready.end() || *it < *next)) {
+                next = it;
+            }
+        }
+
+        if (next == ready.end()) {
+            next = std::min_element(ready.begin(), ready.end());
+        }
+
+        int pass = *next;
+        ready.erase(next);
+        m_order.push_back(pass);
+
+        if (!m_passes[pass].writes.empty()) {
+            bound = m_passes[pass].writes[0].resource;
+        }
+
+        for (int dependent : edges[pass]) {
+            if (--inDegree[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    }
+}
+
+void FrameGraph::computeLifetimes() {
+    for (auto& resource : m_resources) {
+        resource.firstUse = -1;
+        resource.lastUse = -1;
+    }
+
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        const auto& pass = m_passes[m_order[i]];
+
+        auto use = [&](FrameGraphResource _resource) {
+            auto& resource = m_resources[_resource];
+            if (resource.firstUse < 0) {
+                resource.firstUse = i;
+            }
+            resource.lastUse = i;
+        };
+
+        for (FrameGraphResource read : pass.reads) { use(read); }
+        for (const auto& write : pass.writes) { use(write.resource); }
+    }
+}
+
+bool FrameGraph::compile() {
+    m_compiled = true;
+    m_valid = true;
+
+    // a pass renders to a single framebuffer, multiple render targets are declared as one
+    // resource with several color attachments
+    for (const auto& pass : m_passes) {
+        if (pass.writes.size() > 1) {
+            WARN("Pass %s writes to %d resources, declare a single resource with several color "
+                "attachments instead\n", pass.name.c_str(), (int)pass.writes.size());
+            m_valid = false;
+        }
+    }
+
+    if (!m_valid) {
+        m_order.clear();
+        return false;
+    }
+
+    cull();
+    sort();
+    computeLifetimes();
+
+    return true;
+}
+
+int FrameGraph::acquireTarget(const FrameGraphTargetDesc& _desc, uint _width, uint _height) {
+    for (size_t i = 0; i < m_pool.size(); ++i) {
+        auto& pooled = m_pool[i];
+
+        if (!pooled.inUse && pooled.desc.setup == _desc.setup && pooled.width == _width && pooled.height == _height) {
+            pooled.inUse = true;
+            return i;
+        }
+    }
+
+    PooledTarget pooled;
+    pooled.desc = _desc;
+    pooled.width = _width;
+    pooled.height = _height;
+    pooled.inUse = true;
+    pooled.target = std::make_unique<RenderTarget>(_desc.setup);
+    pooled.target->create(_width, _height);
+
+    m_pool.push_back(std::move(pooled));
+
+    return m_pool.size() - 1;
+}
+
+void FrameGraph::execute(uint _width, uint _height) {
+    if (!m_compiled) {
+        compile();
+    }
+
+    // the graph failed to compile, the error was reported once by compile()
+    if (!m_valid) {
+        return;
+    }
+
+    std::vector<bool> cleared(m_resources.size(), false);
+    std::vector<bool> unresolved(m_resources.size(), false);
+    std::vector<bool> used(m_pool.size(), false);
+    FrameGraphResource bound = -1;
+
+    for (auto& pooled : m_pool) {
+        pooled.inUse = false;
+    }
+
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        auto& pass = m_passes[m_order[i]];
+
+        // allocate the transient resources at their first use, aliasing released ones
+        auto allocate = [&](FrameGraphResource _resource) {
+            auto& resource = m_resources[_resource];
+            if (resource.imported || resource.firstUse != (int)i) {
+                return;
+            }
+            uint width = resource.desc.width > 0 ? resource.desc.width : _width;
+            uint height = resource.desc.height > 0 ? resource.desc.height : _height;
+            resource.physical = acquireTarget(resource.desc, width, height);
+            used.resize(m_pool.size(), false);
+            used[resource.physical] = true;
+        };
+
+        for (FrameGraphResource read : pass.reads) { allocate(read); }
+        for (const auto& write : pass.writes) { allocate(write.resource); }
+
+        if (!pass.writes.empty()) {
+            const auto& write = pass.writes[0];
+            auto& resource = m_resources[write.resource];
+            bool clear = write.clear && !cleared[write.resource];
+
+            if (resource.imported) {
+                if (clear) {
+                    float r = (write.clearColor >> 24) & 0xff;
+                    float g = (write.clearColor >> 16) & 0xff;
+                    float b = (write.clearColor >>  8) & 0xff;
+                    float a = (write.clearColor >>  0) & 0xff;
+                    GL_CHECK(glClearColor(r / 255.0, g / 255.0, b / 255.0, a / 255.0));
+                }
+
+                if (bound != write.resource || clear) {
+                    RenderTarget::applyDefault(_width, _height, clear);
+                }
+            } else {
+                const auto& pooled = m_pool[resource.physical];
+
+                if (bound != write.resource) {
+                    pooled.target->bind(pooled.width, pooled.height);
+                }
+
+                if (clear) {
+                    pooled.target->clear(write.clearColor);
+                }
+            }
+
+            cleared[write.resource] = true;
+            bound = write.resource;
+        }
+
+        // multisampled targets are resolved once between their last write and the first read
+        for (FrameGraphResource read : pass.reads) {
+            if (unresolved[read]) {
+                m_pool[m_resources[read].physical].target->resolve();
+                unresolved[read] = false;
+            }
+        }
+
+        pass.execute(*this);
+
+        for (const auto& write : pass.writes) {
+            const auto& resource = m_resources[write.resource];
+            if (!resource.imported) {
+                unresolved[write.resource] = m_pool[resource.physical].target->isMultisampled();
+            }
+        }
+
+        // release the transient resources after their last use so that later ones can alias them
+        for (auto& resource : m_resources) {
+            if (!resource.imported && resource.lastUse == (int)i && resource.physical >= 0) {
+                m_pool[resource.physical].inUse = false;
+            }
+        }
+    }
+
+    // drop the render targets that weren't needed by this execution, e.g. after a resize
+    for (int i = m_pool.size() - 1; i >= 0; --i) {
+        if (!used[i]) {
+            m_pool.erase(m_pool.begin() + i);
+        }
+    }
+
+    for (auto& resource : m_resources) {
+        resource.physical = -1;
+    }
+}
+
+RenderTarget* FrameGraph::getRenderTarget(FrameGraphResource _resource) const {
+    if (_resource < 0 || _resource >= (int)m_resources.size()) {
+        WARN("Getting the render target of invalid frame graph resource %d\n", _resource);
+        return nullptr;
+    }
+
+    const auto& resource = m_resources[_resource];
+
+    // imported resources, like the backbuffer, aren't backed by a render target of the graph
+    if (resource.imported || resource.physical < 0) {
+        WARN("Frame graph resource %s is not allocated\n", resource.name.c_str());
+        return nullptr;
+    }
+
+    return m_pool[resource.physical].target.get();
+}
+
+void FrameGraph::bindRenderTexture(FrameGraphResource _resource, GLuint _slot) const {
+    RenderTarget* target = getRenderTarget(_resource);
+
+    if (target) {
+        target->bindRenderTexture(_slot);
+    }
+}
+
+std::vector<std::string> FrameGraph::getExecutionOrder() const {
+    std::vector<std::string> order;
+
+    for (int pass : m_order) {
+        order.push_back(m_passes[pass].name);
+    }
+
+    return order;
+}
+
+} // OGLW
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "gl/renderTarget.h"
+#include "core/types.h"
+
+namespace OGLW {
+
+class FrameGraph;
+
+// handle on a frame graph resource, only valid for the graph that created it
+typedef int FrameGraphResource;
+
+struct FrameGraphTargetDesc {
+    // size of the render target, 0 means the size given when executing the graph
+    uint width = 0;
+    uint height = 0;
+    RenderTargetSetup setup;
+};
+
+class FrameGraphPassBuilder {
+public:
+    // create a transient render target, its lifetime is managed by the graph
+    FrameGraphResource create(const std::string& _name, FrameGraphTargetDesc _desc);
+    // declare that the pass samples from a resource, multisampled resources are resolved before the pass
+    FrameGraphResource read(FrameGraphResource _resource);
+    // declare that the pass renders to a resource, the first pass writing it clears it if asked to,
+    // a pass writes to a single resource, which may have several color attachments
+    FrameGraphResource write(FrameGraphResource _resource, bool _clear = false, uint _clearColor = 0x0);
+    // prevent the pass from being culled even if nothing reads its output
+    void setSideEffect();
+
+private:
+    friend class FrameGraph;
+    FrameGraphPassBuilder(FrameGraph& _graph, int _pass) : m_graph(_graph), m_pass(_pass) {}
+
+    FrameGraph& m_graph;
+    int m_pass;
+};
+
+class FrameGraph {
+public:
+    typedef std::function<void(FrameGraphPassBuilder&)> SetupFn;
+    typedef std::function<void(const FrameGraph&)> ExecuteFn;
+
+    FrameGraph();
+    ~FrameGraph();
+
+    // get the handle of the default framebuffer
+    FrameGraphResource getBackbuffer() const { return m_backbuffer; }
+    // add a pass, _setup is called immediately to declare the pass resources
+    void addPass(const std::string& _name, SetupFn _setup, ExecuteFn _execute);
+    // cull unused passes, order them and compute the lifetimes of the transient resources, fails
+    // when a pass writes to more than one resource, the graph is not executed then
+    bool compile();
+    // execute the compiled passes, _width and _height are the size of the default framebuffer
+    void execute(uint _width, uint _height);
+    // remove all the passes and resources, the allocated render targets are kept for reuse
+    void reset();
+    // get the render target backing a transient resource, only valid while executing, nullptr for
+    // imported resources or resources not allocated at this point of the execution
+    RenderTarget* getRenderTarget(FrameGraphResource _resource) const;
+    // bind the render texture of a transient resource to the specified slot
+    void bindRenderTexture(FrameGraphResource _resource, GLuint _slot) const;
+    // get the execution order of the passes that survived culling, as names
+    std::vector<std::string> getExecutionOrder() const;
+
+private:
+    friend class FrameGraphPassBuilder;
+
+    struct Resource {
+        std::string name;
+        FrameGraphTargetDesc desc;
+        bool imported;
+        // passes reading and writing the resource, in declaration order
+        std::vector<int> readers;
+        std::vector<int> writers;
+        // first and last use in execution order
+        int firstUse;
+        int lastUse;
+        // index of the physical render target in the pool
+        int physical;
+        int refCount;
+    };
+
+    struct Write {
+        FrameGraphResource resource;
+        bool clear;
+        uint clearColor;
+    };
+
+    struct Pass {
+        std::string name;
+        ExecuteFn execute;
+        std::vector<FrameGraphResource> reads;
+        std::vector<Write> writes;
+        bool sideEffect;
+        bool culled;
+        int refCount;
+    };
+
+    struct PooledTarget {
+        FrameGraphTargetDesc desc;
+        uint width;
+        uint height;
+        bool inUse;
+        std::unique_ptr<RenderTarget> target;
+    };
+
+    void cull();
+    void sort();
+    void computeLifetimes();
+    int acquireTarget(const FrameGraphTargetDesc& _desc, uint _width, uint _height);
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    // indices in m_passes of the passes to execute, in order
+    std::vector<int> m_order;
+    // render targets are kept from a frame to another and aliased between resources
+    std::vector<PooledTarget> m_pool;
+    FrameGraphResource m_backbuffer;
+    bool m_compiled;
+    // whether the last compilation succeeded
+    bool m_valid;
+};
+
+} // OGLW
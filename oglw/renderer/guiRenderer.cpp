@@ -1,6 +1,7 @@
 #include "guiRenderer.h"
 
 #include "gl/renderState.h"
+#include <cstring>
 
 namespace OGLW {
 
@@ -47,12 +48,12 @@ void GuiRenderer::init(GLFWwindow* window, bool _installGlfwCallbacks) {
         {"color", 4, GL_UNSIGNED_BYTE, true, 0, AttributeLocation::color},
     }));
 
-    GL_CHECK(glGenBuffers(1, &m_vertexBuffer));
-    GL_CHECK(glGenBuffers(1, &m_indexBuffer));
+    m_vertexBuffer = std::make_unique<StreamBuffer>(3 * 1024 * 1024);
+    m_indexBuffer = std::make_unique<StreamBuffer>(3 * 512 * 1024);
 
     m_vao = std::make_unique<Vao>();
 
-    m_vao->init(m_vertexBuffer, 0, *m_vertexLayout, m_vertexLayout->getLocations());
+    m_vao->init(m_vertexBuffer->getGlHandle(), m_indexBuffer->getGlHandle(), *m_vertexLayout, m_vertexLayout->getLocations());
     m_shader->bindVertexLayout(*m_vertexLayout);
 
     ImGuiIO& io = ImGui::GetIO();
@@ -106,10 +107,7 @@ void GuiRenderer::init(GLFWwindow* window, bool _installGlfwCallbacks) {
     io.Fonts->TexID = (void *)(intptr_t)m_texture->getGlHandle();
 }
 
-GuiRenderer::~GuiRenderer() {
-    glDeleteBuffers(1, &m_indexBuffer);
-    glDeleteBuffers(1, &m_vertexBuffer);
-}
+GuiRenderer::~GuiRenderer() {}
 
 void GuiRenderer::loadTheme() {
     ImGuiStyle& style = ImGui::GetStyle();
@@ -284,47 +282,79 @@ void GuiRenderer::render(ImDrawData* _drawData) {
 
     _drawData->ScaleClipRects(ImGui::GetIO().DisplayFramebufferScale);
 
-    // TODO: add to render states
-    GL_CHECK(glBlendEquation(GL_FUNC_ADD));
-    GL_CHECK(glEnable(GL_SCISSOR_TEST));
+    RenderState::blendingEquation(GL_FUNC_ADD);
+
+    GLsizeiptr vertexSize = (GLsizeiptr)_drawData->TotalVtxCount * sizeof(ImDrawVert);
+    GLsizeiptr indicesSize = (GLsizeiptr)_drawData->TotalIdxCount * sizeof(ImDrawIdx);
+    GLintptr vertexOffset, indexOffset;
+
+    if (vertexSize == 0 || indicesSize == 0) {
+        self->m_vao->unbind();
+        return;
+    }
+
+    // upload all the command lists at once, one after the other
+    void* vertexData = self->m_vertexBuffer->map(vertexSize, sizeof(ImDrawVert), vertexOffset);
+    void* indexData = vertexData ? self->m_indexBuffer->map(indicesSize, sizeof(ImDrawIdx), indexOffset) : nullptr;
+
+    if (!vertexData || !indexData) {
+        self->m_vertexBuffer->unmap();
+        self->m_vao->unbind();
+        return;
+    }
+
+    GLbyte* vertices = static_cast<GLbyte*>(vertexData);
+    GLbyte* indices = static_cast<GLbyte*>(indexData);
 
     for (int n = 0; n < _drawData->CmdListsCount; n++) {
         const ImDrawList* cmdList = _drawData->CmdLists[n];
-        const ImDrawIdx* idxBufferOffset = 0;
+        GLsizeiptr listVertexSize = (GLsizeiptr)cmdList->VtxBuffer.size() * sizeof(ImDrawVert);
+        GLsizeiptr listIndicesSize = (GLsizeiptr)cmdList->IdxBuffer.size() * sizeof(ImDrawIdx);
 
-        GLsizeiptr vertexSize = (GLsizeiptr)cmdList->VtxBuffer.size() * sizeof(ImDrawVert);
-        GLsizeiptr indicesSize = (GLsizeiptr)cmdList->IdxBuffer.size() * sizeof(ImDrawIdx);
+        std::memcpy(vertices, &cmdList->VtxBuffer.front(), listVertexSize);
+        std::memcpy(indices, &cmdList->IdxBuffer.front(), listIndicesSize);
 
-        GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, self->m_vertexBuffer));
-        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertexSize,
-            (GLvoid*)&cmdList->VtxBuffer.front(), GL_STREAM_DRAW));
+        vertices += listVertexSize;
+        indices += listIndicesSize;
+    }
 
-        GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, self->m_indexBuffer));
-        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize,
-            (GLvoid*)&cmdList->IdxBuffer.front(), GL_STREAM_DRAW));
+    self->m_vertexBuffer->unmap();
+    self->m_indexBuffer->unmap();
+
+    // the command list indices are relative to the list first vertex
+    GLint baseVertex = vertexOffset / sizeof(ImDrawVert);
+    const ImDrawIdx* idxBufferOffset = (const ImDrawIdx*)indexOffset;
+
+    RenderState::scissorTest(GL_TRUE);
+
+    for (int n = 0; n < _drawData->CmdListsCount; n++) {
+        const ImDrawList* cmdList = _drawData->CmdLists[n];
 
         for (const ImDrawCmd* pcmd = cmdList->CmdBuffer.begin(); pcmd != cmdList->CmdBuffer.end(); pcmd++) {
             if (pcmd->UserCallback) {
                 pcmd->UserCallback(cmdList, pcmd);
             } else {
+                RenderState::scissor((int)pcmd->ClipRect.x,
+                                     (int)(height - pcmd->ClipRect.w),
+                                     (int)(pcmd->ClipRect.z - pcmd->ClipRect.x),
+                                     (int)(pcmd->ClipRect.w - pcmd->ClipRect.y));
 
-                // TODO: add to render states
-                GL_CHECK(glScissor((int)pcmd->ClipRect.x,
-                                   (int)(height - pcmd->ClipRect.w),
-                                   (int)(pcmd->ClipRect.z - pcmd->ClipRect.x),
-                                   (int)(pcmd->ClipRect.w - pcmd->ClipRect.y)));
-
-                GL_CHECK(glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount,
-                    sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idxBufferOffset));
+                GL_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount,
+                    sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idxBufferOffset, baseVertex));
             }
 
             idxBufferOffset += pcmd->ElemCount;
         }
+
+        baseVertex += cmdList->VtxBuffer.size();
     }
 
-    GL_CHECK(glDisable(GL_SCISSOR_TEST));
+    RenderState::scissorTest(GL_FALSE);
 
     self->m_vao->unbind();
+
+    self->m_vertexBuffer->endFrame();
+    self->m_indexBuffer->endFrame();
 }
 
 } // OGLW
@@ -9,6 +9,7 @@
 #include "gl/vao.h"
 #include "gl/texture.h"
 #include "gl/vertexLayout.h"
+#include "gl/streamBuffer.h"
 
 namespace OGLW {
 
@@ -38,8 +39,8 @@ private:
         std::unique_ptr<VertexLayout> m_vertexLayout;
         std::unique_ptr<Vao> m_vao;
         std::unique_ptr<Texture> m_texture;
-        GLuint m_vertexBuffer;
-        GLuint m_indexBuffer;
+        std::unique_ptr<StreamBuffer> m_vertexBuffer;
+        std::unique_ptr<StreamBuffer> m_indexBuffer;
 
         bool m_mousePressed[3] = { false, false, false };
         float m_mouseWheel = 0.0f;
@@ -0,0 +1,210 @@
+#include "meshBatch.h"
+#include "gl/renderState.h"
+#include "core/log.h"
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+namespace OGLW {
+
+MeshBatch::MeshBatch(std::shared_ptr<VertexLayout> _vertexLayout, GLsizei _drawDataSize, GLenum _drawMode) :
+    m_vertexLayout(_vertexLayout),
+    m_drawMode(_drawMode),
+    m_drawDataSize(_drawDataSize),
+    m_glVertexBuffer(0),
+    m_glIndexBuffer(0),
+    m_drawCapacity(0),
+    m_geometryDirty(false)
+{
+    // the draw data is fetched as vec4 texels
+    m_drawDataStride = (_drawDataSize + 15) / 16 * 16;
+
+    m_drawIdLayout = std::unique_ptr<VertexLayout>(new VertexLayout({
+        {"drawId", 1, GL_FLOAT, false, 0, AttributeLocation::drawId, 1},
+    }));
+
+    GL_CHECK(glGenBuffers(1, &m_glDrawIdBuffer));
+    GL_CHECK(glGenBuffers(1, &m_glDrawDataBuffer));
+    GL_CHECK(glGenBuffers(1, &m_glCommandBuffer));
+    GL_CHECK(glGenTextures(1, &m_glDrawDataTexture));
+}
+
+MeshBatch::~MeshBatch() {
+    GLuint buffers[] = { m_glVertexBuffer, m_glIndexBuffer, m_glDrawIdBuffer, m_glDrawDataBuffer, m_glCommandBuffer };
+
+    for (GLuint buffer : buffers) {
+        if (buffer) {
+            GL_CHECK(glDeleteBuffers(1, &buffer));
+        }
+    }
+
+    GL_CHECK(glDeleteTextures(1, &m_glDrawDataTexture));
+}
+
+uint MeshBatch::addGeometry(const GLvoid* _vertices, GLsizei _nVertices, const GLuint* _indices, GLsizei _nIndices) {
+    GLsizei stride = m_vertexLayout->getStride();
+    GLint baseVertex = m_vertices.size() / stride;
+
+    m_geometries.push_back({ GLuint(m_indices.size()), GLuint(_nIndices), baseVertex });
+
+    const GLbyte* vertices = static_cast<const GLbyte*>(_vertices);
+    m_vertices.insert(m_vertices.end(), vertices, vertices + _nVertices * stride);
+    m_indices.insert(m_indices.end(), _indices, _indices + _nIndices);
+
+    m_geometryDirty = true;
+
+    return m_geometries.size() - 1;
+}
+
+void MeshBatch::draw(uint _geometry, const GLvoid* _drawData) {
+    // the geometry was rejected, addMesh already warned about it
+    if (_geometry == invalidGeometry) {
+        return;
+    }
+
+    if (_geometry >= m_geometries.size()) {
+        WARN("Unknown batch geometry %d\n", _geometry);
+        return;
+    }
+
+    GLuint data = m_draws.size();
+    // only the size given by the caller is read, the padding up to the stride is zeroed
+    m_drawData.resize((data + 1) * m_drawDataStride);
+    GLbyte* dst = m_drawData.data() + data * m_drawDataStride;
+    std::memcpy(dst, _drawData, m_drawDataSize);
+    std::memset(dst + m_drawDataSize, 0, m_drawDataStride - m_drawDataSize);
+
+    m_draws.push_back({ _geometry, data });
+}
+
+void MeshBatch::uploadGeometry() {
+    if (!m_glVertexBuffer) {
+        GL_CHECK(glGenBuffers(1, &m_glVertexBuffer));
+        GL_CHECK(glGenBuffers(1, &m_glIndexBuffer));
+    }
+
+    // the vertex array keeps the element array binding, don't modify the one of a bound vertex array
+    GL_CHECK(glBindVertexArray(0));
+
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glVertexBuffer));
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_vertices.size(), m_vertices.data(), GL_STATIC_DRAW));
+    GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glIndexBuffer));
+    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), m_indices.data(),
+        GL_STATIC_DRAW));
+
+    if (!m_vao) {
+        m_vao = std::unique_ptr<Vao>(new Vao());
+        m_vao->init(m_glVertexBuffer, m_glIndexBuffer, *m_vertexLayout, m_vertexLayout->getLocations());
+
+        // the draw id attribute is part of the vertex array
+        m_vao->bind();
+        GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glDrawIdBuffer));
+        m_drawIdLayout->enable(m_drawIdLayout->getLocations());
+        m_vao->unbind();
+    }
+
+    m_geometryDirty = false;
+}
+
+void MeshBatch::reserveDraws(GLsizei _nDraws) {
+    if (_nDraws <= m_drawCapacity) {
+        return;
+    }
+
+    m_drawCapacity = std::max(_nDraws, m_drawCapacity * 2);
+
+    std::vector<float> drawIds(m_drawCapacity);
+    std::iota(drawIds.begin(), drawIds.end(), 0.0f);
+
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glDrawIdBuffer));
+    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, drawIds.size() * sizeof(float), drawIds.data(), GL_STATIC_DRAW));
+}
+
+void MeshBatch::buildCommands() {
+    std::stable_sort(m_draws.begin(), m_draws.end(), [](const Draw& _a, const Draw& _b) {
+        return _a.geometry < _b.geometry;
+    });
+
+    m_commands.clear();
+    m_sortedDrawData.resize(m_drawData.size());
+
+    for (size_t i = 0; i < m_draws.size(); ++i) {
+        const Draw& draw = m_draws[i];
+
+        std::memcpy(m_sortedDrawData.data() + i * m_drawDataStride,
+            m_drawData.data() + draw.data * m_drawDataStride, m_drawDataStride);
+
+        // consecutive draws of a geometry are instances of the same command
+        if (i > 0 && m_draws[i - 1].geometry == draw.geometry) {
+            m_commands.back().instanceCount++;
+            continue;
+        }
+
+        const Geometry& geometry = m_geometries[draw.geometry];
+        m_commands.push_back({ geometry.indexCount, 1, geometry.firstIndex, geometry.baseVertex, GLuint(i) });
+    }
+}
+
+void MeshBatch::submit(Shader& _shader, GLuint _textureUnit) {
+    if (m_draws.empty()) {
+        m_commands.clear();
+        return;
+    }
+
+    if (m_geometryDirty) {
+        uploadGeometry();
+    }
+
+    buildCommands();
+    reserveDraws(m_draws.size());
+
+    // invalidate the draw data of the previous frame before writing the new one
+    GLsizeiptr drawDataBytes = m_sortedDrawData.size();
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, m_glDrawDataBuffer));
+    GL_CHECK(glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(m_drawCapacity) * m_drawDataStride, NULL, GL_STREAM_DRAW));
+    GL_CHECK(glBufferSubData(GL_TEXTURE_BUFFER, 0, drawDataBytes, m_sortedDrawData.data()));
+    GL_CHECK(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+    RenderState::textureUnit(_textureUnit);
+    RenderState::texture(GL_TEXTURE_BUFFER, m_glDrawDataTexture);
+    GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_glDrawDataBuffer));
+
+    _shader.bindVertexLayout(*m_vertexLayout);
+    _shader.bindVertexLayout(*m_drawIdLayout);
+    _shader.use();
+    _shader.setUniform("drawData", int(_textureUnit));
+
+    m_vao->bind();
+
+    // the draw ids are fed through the base instance of the commands, which multi draw indirect
+    // alone doesn't honor
+    bool multiDrawIndirect = GLEW_VERSION_4_3 ||
+        (GLEW_ARB_multi_draw_indirect && (GLEW_VERSION_4_2 || GLEW_ARB_base_instance));
+
+    if (multiDrawIndirect) {
+        GL_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_glCommandBuffer));
+        GL_CHECK(glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commands.size() * sizeof(DrawElementsIndirectCommand),
+            m_commands.data(), GL_STREAM_DRAW));
+        GL_CHECK(glMultiDrawElementsIndirect(m_drawMode, GL_UNSIGNED_INT, NULL, m_commands.size(), 0));
+        GL_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+    } else {
+        const auto& locations = m_drawIdLayout->getLocations();
+        GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_glDrawIdBuffer));
+
+        for (const auto& command : m_commands) {
+            // without base instance, the first draw id of the command is the attribute offset
+            m_drawIdLayout->enable(locations, command.baseInstance * sizeof(float));
+            GL_CHECK(glDrawElementsInstancedBaseVertex(m_drawMode, command.count, GL_UNSIGNED_INT,
+                (GLvoid*)(command.firstIndex * sizeof(GLuint)), command.instanceCount, command.baseVertex));
+        }
+
+        m_drawIdLayout->enable(locations);
+    }
+
+    m_vao->unbind();
+
+    m_draws.clear();
+    m_drawData.clear();
+}
+
+} // OGLW
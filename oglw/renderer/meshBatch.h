@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "gl/gl.h"
+#include "gl/mesh.h"
+#include "gl/shader.h"
+#include "gl/vao.h"
+#include "gl/vertexLayout.h"
+
+namespace OGLW {
+
+// an indirect indexed draw, as read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Packs the geometry of meshes sharing a vertex layout into a single vertex and index buffer, and
+// submits the draws queued during a frame as a buffer of indirect commands. Draws of the same geometry
+// are merged in one instanced command. Each draw has its own data, fetched in the shader as vec4 texels
+// of the 'drawData' buffer texture at the index given by the 'drawId' attribute:
+//     in float drawId;
+//     uniform samplerBuffer drawData;
+//     vec4 texel = texelFetch(drawData, int(drawId) * texelsPerDraw + i);
+// The commands are submitted with glMultiDrawElementsIndirect when available along with base
+// instance support, otherwise with one instanced draw per command, rebasing the 'drawId' attribute
+// on the first draw of the command.
+class MeshBatch {
+public:
+    // id returned when a geometry can't be added, drawing it is a no-op
+    static const uint invalidGeometry = ~0u;
+
+    // _drawDataSize is the size in bytes of the data of each draw, rounded up to a multiple of 16
+    MeshBatch(std::shared_ptr<VertexLayout> _vertexLayout, GLsizei _drawDataSize,
+        GLenum _drawMode = GL_TRIANGLES);
+    ~MeshBatch();
+
+    // add a geometry to the shared buffers and return its id, indices are relative to its first vertex
+    uint addGeometry(const GLvoid* _vertices, GLsizei _nVertices, const GLuint* _indices, GLsizei _nIndices);
+    // add the geometry of a mesh not yet uploaded, the mesh layout must match the batch layout,
+    // invalidGeometry when its vertex size differs from the batch stride
+    template <class T>
+    uint addMesh(const Mesh<T>& _mesh) {
+        if (sizeof(T) != (size_t)m_vertexLayout->getStride()) {
+            WARN("Mesh vertex size %d doesn't match the batch vertex stride %d\n", int(sizeof(T)),
+                m_vertexLayout->getStride());
+            return invalidGeometry;
+        }
+
+        const auto& vertices = _mesh.getVertices();
+        const auto& indices = _mesh.getIndices();
+
+        return addGeometry(vertices.data(), vertices.size(), indices.data(), indices.size());
+    }
+    // queue a draw of a geometry for the current frame, _drawData points to the data of the draw
+    void draw(uint _geometry, const GLvoid* _drawData);
+    // queue a draw of a geometry for the current frame with a draw data structure
+    template <class T>
+    void draw(uint _geometry, const T& _drawData) {
+        draw(_geometry, static_cast<const GLvoid*>(&_drawData));
+    }
+    // submit the draws queued since the last submit, the draw data buffer texture is bound on _textureUnit
+    void submit(Shader& _shader, GLuint _textureUnit = 0);
+    // number of draws queued for the current frame
+    size_t numDraws() const { return m_draws.size(); }
+    // number of commands of the last submit
+    size_t numCommands() const { return m_commands.size(); }
+    // number of geometries in the batch
+    size_t numGeometries() const { return m_geometries.size(); }
+
+private:
+    struct Geometry {
+        GLuint firstIndex;
+        GLuint indexCount;
+        GLint baseVertex;
+    };
+
+    struct Draw {
+        uint geometry;
+        // index of the data of the draw in m_drawData
+        GLuint data;
+    };
+
+    // upload the geometry added since the last submit and create the vertex array
+    void uploadGeometry();
+    // sort the draws by geometry and build the commands and the draw data in command order
+    void buildCommands();
+    // make room for _nDraws draws in the draw id and draw data buffers
+    void reserveDraws(GLsizei _nDraws);
+
+    std::shared_ptr<VertexLayout> m_vertexLayout;
+    // the per instance draw id attribute, sourcing an increasing sequence of draw indices
+    std::unique_ptr<VertexLayout> m_drawIdLayout;
+    std::unique_ptr<Vao> m_vao;
+    GLenum m_drawMode;
+    // size of the data of each draw given by the caller, and once padded to whole vec4 texels
+    GLsizei m_drawDataSize;
+    GLsizei m_drawDataStride;
+
+    GLuint m_glVertexBuffer;
+    GLuint m_glIndexBuffer;
+    GLuint m_glDrawIdBuffer;
+    GLuint m_glDrawDataBuffer;
+    GLuint m_glDrawDataTexture;
+    GLuint m_glCommandBuffer;
+    // capacity of the draw id and draw data buffers in draws
+    GLsizei m_drawCapacity;
+
+    std::vector<GLbyte> m_vertices;
+    std::vector<GLuint> m_indices;
+    std::vector<Geometry> m_geometries;
+    bool m_geometryDirty;
+
+    std::vector<Draw> m_draws;
+    std::vector<GLbyte> m_drawData;
+    std::vector<GLbyte> m_sortedDrawData;
+    std::vector<DrawElementsIndirectCommand> m_commands;
+};
+
+} // OGLW
@@ -0,0 +1,130 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include "oglw.h"
+
+template <class T>
+using uptr = std::unique_ptr<T>;
+using namespace OGLW;
+
+struct DrawData {
+    glm::mat4 model;
+    glm::vec4 color;
+};
+
+// ------------------------------------------------------------------------------
+// OGLW App
+class TestApp : public App {
+    public:
+        TestApp() : App({"OGLW::TestApp", false, false, 800, 600}) {}
+        void update(float _dt) override;
+        void render(float _dt) override;
+        void init() override;
+
+    private:
+        uptr<Shader> m_shader;
+        uptr<MeshBatch> m_batch;
+        std::vector<uint> m_geometries;
+        // half extent of the bounding box of each geometry, around its origin
+        std::vector<glm::vec3> m_extents;
+        uint m_wallGeometry;
+        SphereArray m_spheres;
+        AABBArray m_boxes;
+        std::vector<uint> m_visible;
+        OcclusionCuller m_occlusion;
+};
+OGLWMain(TestApp);
+
+void TestApp::init() {
+    m_camera.setPosition({0.0, 20.0, -60.0});
+    m_camera.rotate({-0.3, M_PI});
+    m_camera.setFar(500.f);
+    m_camera.setNear(0.1f);
+    m_camera.setFov(45);
+
+    m_shader = uptr<Shader>(new Shader("batched.glsl"));
+
+    // pack cubes of different sizes in the shared buffers of the batch
+    for (float size : { 0.2f, 0.35f, 0.5f }) {
+        auto mesh = cube(size);
+
+        if (!m_batch) {
+            m_batch = uptr<MeshBatch>(new MeshBatch(mesh->getVertexLayout(), sizeof(DrawData)));
+        }
+
+        glm::vec3 extent(0.f);
+        for (const auto& vertex : mesh->getVertices()) {
+            extent = glm::max(extent, glm::abs(vertex.position));
+        }
+
+        m_geometries.push_back(m_batch->addMesh(*mesh));
+        m_extents.push_back(extent);
+    }
+
+    m_wallGeometry = m_batch->addMesh(*cube(1.0f));
+}
+
+// the corners and faces of the unit cube the wall is made of
+static const float wallPositions[] = {
+    -1.f, -1.f,  1.f,   1.f, -1.f,  1.f,  -1.f,  1.f,  1.f,   1.f,  1.f,  1.f,
+    -1.f, -1.f, -1.f,   1.f, -1.f, -1.f,  -1.f,  1.f, -1.f,   1.f,  1.f, -1.f,
+};
+static const uint wallIndices[] = {
+    5, 1, 3, 3, 7, 5, 6, 2, 0, 0, 4, 6, 2, 6, 7, 7, 3, 2,
+    5, 4, 0, 0, 1, 5, 0, 2, 3, 3, 1, 0, 7, 6, 4, 4, 5, 7,
+};
+
+void TestApp::update(float _dt) {
+    oglwUpdateFreeFlyCamera(_dt, 'S', 'W', 'A', 'D', 1e-3f);
+}
+
+void TestApp::render(float _dt) {
+    RenderState::depthWrite(GL_TRUE);
+    RenderState::depthTest(GL_TRUE);
+    RenderState::culling(GL_TRUE);
+    RenderState::cullFace(GL_BACK);
+
+    const int side = 100;
+    m_spheres.resize(side * side);
+    m_boxes.resize(side * side);
+
+    for (int x = 0; x < side; ++x) {
+        for (int z = 0; z < side; ++z) {
+            glm::vec3 position(x - side * 0.5f, sin(m_globalTime * 2.f + x * 0.3f) * 2.f, z - side * 0.5f);
+            // the bounds enclose the whole cube, its corners included
+            const glm::vec3& extent = m_extents[(x + z) % m_geometries.size()];
+            m_spheres.set(x * side + z, position, glm::length(extent));
+            m_boxes.set(x * side + z, position - extent, position + extent);
+        }
+    }
+
+    const glm::mat4& viewProj = m_camera.getViewProjectionMatrix();
+    glm::mat4 wall = glm::scale(glm::translate(glm::mat4(), glm::vec3(0.f, 4.f, -20.f)), glm::vec3(25.f, 8.f, 0.5f));
+
+    // the wall hides the cubes behind it, they are skipped before being queued
+    m_occlusion.begin(viewProj);
+    m_occlusion.addOccluder(wallPositions, 8, 3 * sizeof(float), wallIndices, 36, wall);
+    m_occlusion.rasterize();
+
+    // only the cubes in the camera frustum and not behind the wall are queued in the batch
+    cullSpheres(m_camera.getFrustum(), m_spheres, m_visible);
+    m_occlusion.cull(m_boxes, m_visible);
+
+    m_batch->draw(m_wallGeometry, DrawData{ wall, glm::vec4(0.4f, 0.4f, 0.4f, 1.f) });
+
+    for (uint index : m_visible) {
+        int x = index / side;
+        int z = index % side;
+        glm::vec3 position(m_spheres.x[index], m_spheres.y[index], m_spheres.z[index]);
+        DrawData data = {
+            glm::translate(glm::mat4(), position),
+            glm::vec4(float(x) / side, 0.5f, float(z) / side, 1.f)
+        };
+        m_batch->draw(m_geometries[(x + z) % m_geometries.size()], data);
+    }
+
+    m_shader->setUniform("viewProj", viewProj);
+
+    // up to 10k draws of 3 geometries submitted as 3 indirect commands
+    m_batch->submit(*m_shader);
+}
@@ -0,0 +1,42 @@
+#pragma begin:vertex
+#version 330
+
+in vec3 position;
+in vec3 normal;
+in float drawId;
+
+uniform mat4 viewProj;
+uniform samplerBuffer drawData;
+
+out vec3 f_normal;
+out vec3 f_color;
+
+void main() {
+    // a model matrix and a color per draw, 5 texels
+    int base = int(drawId) * 5;
+    mat4 model = mat4(texelFetch(drawData, base + 0),
+                      texelFetch(drawData, base + 1),
+                      texelFetch(drawData, base + 2),
+                      texelFetch(drawData, base + 3));
+
+    f_normal = mat3(model) * normal;
+    f_color = texelFetch(drawData, base + 4).rgb;
+    gl_Position = viewProj * model * vec4(position, 1.0);
+}
+
+#pragma end:vertex
+
+#pragma begin:fragment
+#version 330
+
+in vec3 f_normal;
+in vec3 f_color;
+
+out vec4 outColour;
+
+void main(void) {
+    float diffuse = max(dot(normalize(f_normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+    outColour = vec4(f_color * (0.2 + 0.8 * diffuse), 1.0);
+}
+
+#pragma end:fragment
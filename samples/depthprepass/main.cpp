@@ -0,0 +1,100 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include "oglw.h"
+
+template <class T>
+using uptr = std::unique_ptr<T>;
+using namespace OGLW;
+
+// ------------------------------------------------------------------------------
+// OGLW App
+class TestApp : public App {
+    public:
+        TestApp() : App({"OGLW::TestApp", false, false, 800, 600}) {}
+        void update(float _dt) override;
+        void render(float _dt) override;
+        void init() override;
+
+    private:
+        void drawCubes(Shader& _shader, bool _shade);
+
+        uptr<Shader> m_shader;
+        uptr<RawMesh> m_cube;
+        DepthPrepass m_depthPrepass;
+        bool m_reverseZKeyDown;
+};
+OGLWMain(TestApp);
+
+void TestApp::init() {
+    m_camera.setPosition({0.0, 5.0, -40.0});
+    m_camera.rotate({-0.1, M_PI});
+    m_camera.setFar(500.f);
+    m_camera.setNear(0.1f);
+    m_camera.setFov(45);
+
+    // depth goes from 1 on the near plane to 0 at infinity, the depth clear value and
+    // comparison follow the projection
+    m_camera.setReverseZ(true);
+    m_camera.applyDepthState();
+    m_reverseZKeyDown = false;
+
+    m_shader = uptr<Shader>(new Shader("default.glsl"));
+    m_cube = cube(0.5f);
+}
+
+void TestApp::update(float _dt) {
+    oglwUpdateFreeFlyCamera(_dt, 'S', 'W', 'A', 'D', 1e-3f);
+
+    // 'R' switches between a reverse Z and a standard projection, the pre-pass must fill the
+    // depth buffer and shade the same fragments with both
+    bool reverseZKeyDown = glfwGetKey(m_window, 'R');
+
+    if (reverseZKeyDown && !m_reverseZKeyDown) {
+        m_camera.setReverseZ(!m_camera.isReverseZ());
+        m_camera.applyDepthState();
+        INFO("Reverse Z %s\n", m_camera.isReverseZ() ? "on" : "off");
+    }
+
+    m_reverseZKeyDown = reverseZKeyDown;
+}
+
+void TestApp::drawCubes(Shader& _shader, bool _shade) {
+    const glm::mat4& viewProj = m_camera.getViewProjectionMatrix();
+    const int side = 20;
+    const int layers = 16;
+
+    // rows of cubes hiding each other, most of their fragments are only shaded without the pre-pass
+    for (int layer = 0; layer < layers; ++layer) {
+        for (int x = 0; x < side; ++x) {
+            for (int y = 0; y < side / 2; ++y) {
+                glm::vec3 position(x - side * 0.5f, y, layer * 2.f + sin(m_globalTime + x * 0.5f) * 0.5f);
+                glm::mat4 model = glm::translate(glm::mat4(), position);
+
+                _shader.setUniform("mvp", viewProj * model);
+
+                if (_shade) {
+                    _shader.setUniform("model", model);
+                    _shader.setUniform("color", glm::vec3(float(x) / side, float(layer) / layers, float(y) * 2.f / side));
+                }
+
+                m_cube->draw(_shader);
+            }
+        }
+    }
+}
+
+void TestApp::render(float _dt) {
+    RenderState::depthWrite(GL_TRUE);
+    RenderState::depthTest(GL_TRUE);
+    RenderState::culling(GL_TRUE);
+    RenderState::cullFace(GL_BACK);
+
+    // the depth only variant fills the depth buffer with the comparison of the camera projection,
+    // then the shading phase only shades the fragments left at equal depth
+    m_depthPrepass.beginDepth();
+    drawCubes(m_depthPrepass.getDepthShader(*m_shader), false);
+    m_depthPrepass.beginShading();
+    drawCubes(*m_shader, true);
+    m_depthPrepass.end();
+}
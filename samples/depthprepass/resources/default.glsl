@@ -0,0 +1,33 @@
+#pragma begin:vertex
+#version 330
+
+in vec3 position;
+in vec3 normal;
+
+uniform mat4 mvp;
+uniform mat4 model;
+
+out vec3 f_normal;
+
+void main() {
+    f_normal = mat3(model) * normal;
+    gl_Position = mvp * vec4(position, 1.0);
+}
+
+#pragma end:vertex
+
+#pragma begin:fragment
+#version 330
+
+in vec3 f_normal;
+
+uniform vec3 color;
+
+out vec4 outColour;
+
+void main(void) {
+    float diffuse = max(dot(normalize(f_normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+    outColour = vec4(color * (0.2 + 0.8 * diffuse), 1.0);
+}
+
+#pragma end:fragment
@@ -0,0 +1,79 @@
+#include <vector>
+#include <string>
+#include <memory>
+#include "oglw.h"
+
+template <class T>
+using uptr = std::unique_ptr<T>;
+using namespace OGLW;
+
+struct Instance {
+    glm::mat4 model;
+    glm::vec3 color;
+};
+
+// ------------------------------------------------------------------------------
+// OGLW App
+class TestApp : public App {
+    public:
+        TestApp() : App({"OGLW::TestApp", false, false, 800, 600}) {}
+        void update(float _dt) override;
+        void render(float _dt) override;
+        void init() override;
+
+    private:
+        uptr<Shader> m_shader;
+        uptr<RawMesh> m_cube;
+        uptr<InstanceBuffer<Instance>> m_instances;
+};
+OGLWMain(TestApp);
+
+void TestApp::init() {
+    m_camera.setPosition({0.0, 20.0, -60.0});
+    m_camera.rotate({-0.3, M_PI});
+    m_camera.setFar(500.f);
+    m_camera.setNear(0.1f);
+    m_camera.setFov(45);
+
+    m_shader = uptr<Shader>(new Shader("instanced.glsl"));
+    m_cube = cube(0.5f);
+
+    // the model matrix spans the 4 locations following AttributeLocation::instance
+    auto layout = std::shared_ptr<VertexLayout>(new VertexLayout({
+        {"instanceModel", 16, GL_FLOAT, false, 0, AttributeLocation::instance, 1},
+        {"instanceColor", 3, GL_FLOAT, false, 0, AttributeLocation::instance + 4, 1},
+    }));
+
+    m_instances = uptr<InstanceBuffer<Instance>>(new InstanceBuffer<Instance>(layout));
+
+    const int side = 100;
+    for (int x = 0; x < side; ++x) {
+        for (int z = 0; z < side; ++z) {
+            glm::vec3 position(x - side * 0.5f, 0.f, z - side * 0.5f);
+            glm::vec3 color(float(x) / side, 0.5f, float(z) / side);
+            m_instances->add({glm::translate(glm::mat4(), position), color});
+        }
+    }
+}
+
+void TestApp::update(float _dt) {
+    oglwUpdateFreeFlyCamera(_dt, 'S', 'W', 'A', 'D', 1e-3f);
+
+    // bounce the cubes, the instance buffer is uploaded again before the next draw
+    for (size_t i = 0; i < m_instances->getInstances().size(); ++i) {
+        Instance& instance = (*m_instances)[i];
+        instance.model[3].y = sin(m_globalTime * 2.f + i * 0.1f) * 2.f;
+    }
+}
+
+void TestApp::render(float _dt) {
+    RenderState::depthWrite(GL_TRUE);
+    RenderState::depthTest(GL_TRUE);
+    RenderState::culling(GL_TRUE);
+    RenderState::cullFace(GL_BACK);
+
+    m_shader->setUniform("viewProj", m_camera.getProjectionMatrix() * m_camera.getViewMatrix());
+
+    // 10k cubes in a single draw call
+    m_cube->drawInstanced(*m_shader, *m_instances);
+}
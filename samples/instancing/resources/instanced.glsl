@@ -0,0 +1,35 @@
+#pragma begin:vertex
+#version 330
+
+in vec3 position;
+in vec3 normal;
+in mat4 instanceModel;
+in vec3 instanceColor;
+
+uniform mat4 viewProj;
+
+out vec3 f_normal;
+out vec3 f_color;
+
+void main() {
+    f_normal = mat3(instanceModel) * normal;
+    f_color = instanceColor;
+    gl_Position = viewProj * instanceModel * vec4(position, 1.0);
+}
+
+#pragma end:vertex
+
+#pragma begin:fragment
+#version 330
+
+in vec3 f_normal;
+in vec3 f_color;
+
+out vec4 outColour;
+
+void main(void) {
+    float diffuse = max(dot(normalize(f_normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+    outColour = vec4(f_color * (0.2 + 0.8 * diffuse), 1.0);
+}
+
+#pragma end:fragment
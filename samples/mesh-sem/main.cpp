@@ -63,7 +63,9 @@ void TestApp::init() {
     m_shader = uptr<OGLW::Shader>(new OGLW::Shader("default.glsl"));
     m_backgroundShader = uptr<OGLW::Shader>(new OGLW::Shader("background.glsl"));
     m_fullQuadShader = uptr<OGLW::Shader>(new OGLW::Shader("fullquad.glsl"));
-    m_mesh = OGLW::loadOBJ("suzanne.blend");
+    OGLW::OBJLoadOptions objOptions;
+    objOptions.lodLevels = 4;
+    m_mesh = OGLW::loadOBJ("suzanne.blend", objOptions);
     m_quad = OGLW::quad(1.f);
     m_texture = uptr<OGLW::Texture>(new OGLW::Texture("lightprobe.jpg"));
     OGLW::RenderTargetSetup setup;
@@ -108,7 +110,10 @@ void TestApp::render(float _dt) {
     m_shader->setUniform("normalmat", normalMat);
     m_shader->setUniform("tex", 0);
     m_shader->setUniform("f", f);
-    m_mesh->draw(*m_shader);
+    // the level of detail error is measured in pixels of the framebuffer
+    int fbWidth, fbHeight;
+    glfwGetFramebufferSize(m_window, &fbWidth, &fbHeight);
+    m_mesh->draw(*m_shader, m_mesh->selectLod(m_camera, model, fbHeight));
 
     /// Draw to default frame buffer
     OGLW::RenderState::depthWrite(GL_FALSE);
@@ -15,9 +15,11 @@ class TestApp : public App {
         void update(float _dt) override;
         void render(float _dt) override;
         void init() override;
+        void setupFrameGraph();
         void captureReflectionTexture(float _yWaterPlane, glm::mat4 _model);
         void drawTerrain(glm::mat4 _model);
-        void drawWater(glm::mat4 _model, float _yWaterPlane);
+        void drawTerrainDepth(glm::mat4 _model);
+        void drawWater(glm::mat4 _model, float _yWaterPlane, Texture& _reflection, Texture& _depth);
 
     private:
         uptr<Shader> m_shader;
@@ -25,10 +27,12 @@ class TestApp : public App {
         uptr<Mesh<glm::vec4>> m_geometry;
         uptr<Mesh<glm::vec4>> m_waterGeometry;
         uptr<Texture> m_texture;
-        uptr<RenderTarget> m_reflectionRenderTarget;
-        uptr<RenderTarget> m_depthRenderTarget;
         uptr<Camera> m_reflectionCamera;
         uptr<QuadRenderer> m_quadRenderer;
+        FrameGraph m_frameGraph;
+        DepthPrepass m_depthPrepass;
+        glm::mat4 m_model;
+        float m_yWaterPlane;
 };
 OGLWMain(TestApp);
 
@@ -57,20 +61,84 @@ void TestApp::init() {
     m_texture = uptr<OGLW::Texture>(new Texture("perlin.png", options));
 
     m_geometry = plane(20.f, 20.f, 350, 350);
+    m_geometry->setOptimize(true);
+    m_geometry->setSplitIndices(true);
     m_waterGeometry = plane(20.f, 20.f, 150, 150);
 
-    RenderTargetSetup setup;
-    setup.useDepth = true;
-    m_reflectionRenderTarget = std::make_unique<OGLW::RenderTarget>(setup);
-    m_reflectionRenderTarget->create(1024, 720);
-
-    RenderTargetSetup depthSetup;
-    depthSetup.useDepthTexture = true;
-    m_depthRenderTarget = std::make_unique<OGLW::RenderTarget>(depthSetup);
-    m_depthRenderTarget->create(1024, 720);
-
     m_quadRenderer = uptr<QuadRenderer>(new QuadRenderer());
     m_quadRenderer->init();
+
+    m_yWaterPlane = 2.0f;
+    m_model = glm::rotate(glm::mat4(), (float) M_PI_2, glm::vec3(1.0, 0.0, 0.0));
+
+    setupFrameGraph();
+}
+
+void TestApp::setupFrameGraph() {
+    FrameGraphResource reflection;
+    FrameGraphResource depth;
+    FrameGraphResource backbuffer = m_frameGraph.getBackbuffer();
+
+    m_frameGraph.addPass("reflection", [&](FrameGraphPassBuilder& _builder) {
+        FrameGraphTargetDesc desc;
+        desc.setup.useDepth = true;
+        desc.setup.samples = 4;
+        reflection = _builder.write(_builder.create("reflection", desc), true, 0xffffffff);
+    }, [this](const FrameGraph& _graph) {
+        captureReflectionTexture(m_yWaterPlane, m_model);
+    });
+
+    m_frameGraph.addPass("depth", [&](FrameGraphPassBuilder& _builder) {
+        FrameGraphTargetDesc desc;
+        desc.setup.useDepthTexture = true;
+        depth = _builder.write(_builder.create("depth", desc), true, 0xffffffff);
+    }, [this](const FrameGraph& _graph) {
+        drawTerrainDepth(m_model);
+    });
+
+    m_frameGraph.addPass("terrain", [&](FrameGraphPassBuilder& _builder) {
+        _builder.write(backbuffer);
+    }, [this](const FrameGraph& _graph) {
+        m_depthPrepass.beginDepth();
+        drawTerrainDepth(m_model);
+        m_depthPrepass.beginShading();
+        drawTerrain(m_model);
+        m_depthPrepass.end();
+    });
+
+    m_frameGraph.addPass("water", [&](FrameGraphPassBuilder& _builder) {
+        _builder.read(reflection);
+        _builder.read(depth);
+        _builder.write(backbuffer);
+    }, [this, reflection, depth](const FrameGraph& _graph) {
+        RenderTarget* reflectionTarget = _graph.getRenderTarget(reflection);
+        RenderTarget* depthTarget = _graph.getRenderTarget(depth);
+        if (!reflectionTarget || !depthTarget) {
+            return;
+        }
+        auto& reflectionTexture = reflectionTarget->getRenderTexture();
+        auto& depthTexture = depthTarget->getDepthRenderTexture();
+        drawWater(m_model, m_yWaterPlane, *reflectionTexture, *depthTexture);
+    });
+
+    /// Debug draw camera framebuffer
+    m_frameGraph.addPass("debug", [&](FrameGraphPassBuilder& _builder) {
+        _builder.read(reflection);
+        _builder.read(depth);
+        _builder.write(backbuffer);
+    }, [this, reflection, depth](const FrameGraph& _graph) {
+        RenderTarget* reflectionTarget = _graph.getRenderTarget(reflection);
+        RenderTarget* depthTarget = _graph.getRenderTarget(depth);
+        if (!reflectionTarget || !depthTarget) {
+            return;
+        }
+        auto& reflectionTexture = reflectionTarget->getRenderTexture();
+        auto& depthTexture = depthTarget->getDepthRenderTexture();
+        m_quadRenderer->render(*reflectionTexture, resolution(), glm::vec2(0.0, 0.0), 256);
+        m_quadRenderer->render(*depthTexture, resolution(), glm::vec2(0.0, 256), 256);
+    });
+
+    m_frameGraph.compile();
 }
 
 void TestApp::update(float _dt) {
@@ -109,13 +177,9 @@ void TestApp::captureReflectionTexture(float _yWaterPlane, glm::mat4 _model) {
     RenderState::cullFace(GL_BACK);
     RenderState::blending(GL_FALSE);
 
-    m_reflectionRenderTarget->apply(1024, 720, 0xffffffff);
-
     m_geometry->draw(*m_shader);
 
     glDisable(GL_CLIP_PLANE0);
-
-    RenderTarget::applyDefault(1024, 720, 0xffffffff);
 }
 
 void TestApp::drawTerrain(glm::mat4 _model) {
@@ -137,12 +201,30 @@ void TestApp::drawTerrain(glm::mat4 _model) {
 
 }
 
-void TestApp::drawWater(glm::mat4 _model, float _yWaterPlane) {
+void TestApp::drawTerrainDepth(glm::mat4 _model) {
+
+    glm::mat4 mvp = m_camera.getProjectionMatrix() * m_camera.getViewMatrix() * _model;
+    Shader& depthShader = m_depthPrepass.getDepthShader(*m_shader);
+
+    m_texture->bind(0);
+
+    depthShader.setUniform("mvp", mvp);
+
+    RenderState::depthTest(GL_TRUE);
+    RenderState::culling(GL_TRUE);
+    RenderState::cullFace(GL_BACK);
+    RenderState::blending(GL_FALSE);
+
+    m_geometry->draw(depthShader);
+
+}
+
+void TestApp::drawWater(glm::mat4 _model, float _yWaterPlane, Texture& _reflection, Texture& _depth) {
 
     glm::mat4 mvp = m_camera.getProjectionMatrix() * m_camera.getViewMatrix() * _model;
 
-    m_reflectionRenderTarget->getRenderTexture()->bind(0);
-    m_depthRenderTarget->getDepthRenderTexture()->bind(1);
+    _reflection.bind(0);
+    _depth.bind(1);
 
     m_waterShader->setUniform("mvp", mvp);
     m_waterShader->setUniform("time", m_globalTime);
@@ -165,28 +247,5 @@ void TestApp::drawWater(glm::mat4 _model, float _yWaterPlane) {
 
 
 void TestApp::render(float _dt) {
-    float yWaterPlane = 2.0f;
-    glm::mat4 model = glm::rotate(glm::mat4(), (float) M_PI_2, glm::vec3(1.0, 0.0, 0.0));
-
-    captureReflectionTexture(yWaterPlane, model);
-
-    /// Draw terrain
-
-    m_depthRenderTarget->apply(1024, 720, 0xffffffff);
-
-    drawTerrain(model);
-
-    RenderTarget::applyDefault(1024, 720, 0xffffffff);
-
-    drawTerrain(model);
-
-    /// Draw water
-
-    drawWater(model, yWaterPlane);
-
-    /// Debug draw camera framebuffer
-
-    m_quadRenderer->render(*m_reflectionRenderTarget->getRenderTexture(), resolution(), glm::vec2(0.0, 0.0), 256);
-    m_quadRenderer->render(*m_depthRenderTarget->getDepthRenderTexture(), resolution(), glm::vec2(0.0, 256), 256);
+    m_frameGraph.execute(1024, 720);
 }
-
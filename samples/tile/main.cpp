@@ -60,7 +60,12 @@ void TestApp::init() {
     m_renderTarget->create(800, 600);
 
     /// Setup meshes
-    m_mesh = loadOBJ("tile.blend");
+    OBJLoadOptions objOptions;
+    objOptions.stripColor = true;
+    objOptions.quantize = true;
+    objOptions.optimize = true;
+    objOptions.lodLevels = 4;
+    m_mesh = loadOBJ("tile.blend", objOptions);
     m_plane = plane(30.f, 30.f, 1, 1);
     m_shadowCasterMesh = cube(0.05);
     m_quad = quad(1.f);
@@ -111,7 +116,10 @@ void TestApp::render(float _dt) {
 
     RenderState::culling(GL_TRUE);
     RenderState::cullFace(GL_BACK);
-    m_mesh->draw(*m_shader);
+    // the level of detail error is measured in pixels of the framebuffer
+    int fbWidth, fbHeight;
+    glfwGetFramebufferSize(m_window, &fbWidth, &fbHeight);
+    m_mesh->draw(*m_shader, m_mesh->selectLod(m_camera, model, fbHeight));
     m_shader->setUniform("mvp", m_camera.getProjectionMatrix() * view * glm::translate(model, {0.0, 0.0, -0.01}));
     RenderState::culling(GL_FALSE);
     m_plane->draw(*m_shader);